@@ -59,6 +59,7 @@ void api_buildSysinfoResponse(JsonDocument &input, JsonDocument &output)
     }
     output["led_brightness"] = Config::getInstance().getLedBrightness();
     output["eth_led_brightness"] = Config::getInstance().getEthBrightness();
+    fillIRSysinfo(output);
 }
 
 void processSetConfig(JsonDocument &input, JsonDocument &output)
@@ -168,6 +169,22 @@ void api_buildIRCodeEvent(JsonDocument &event, String irCode)
     event["ir_code"] = irCode;
 }
 
+void api_buildIRSendDoneEvent(JsonDocument &event, const ir_send_result_t &result)
+{
+    event["type"] = "event";
+    event["msg"] = "ir_send_done";
+    event["req_id"] = result.reqId;
+    event["code"] = result.code;
+    event["stopped"] = result.stopped;
+    event["start_us"] = result.startUs;
+    event["end_us"] = result.endUs;
+    event["repeats_granted"] = result.repeatsGranted;
+    JsonObject channels = event["channels"].to<JsonObject>();
+    channels["internal"] = (result.channels & IR_CHANNEL_INTERNAL) != 0;
+    channels["ext1"] = (result.channels & IR_CHANNEL_EXT1) != 0;
+    channels["ext2"] = (result.channels & IR_CHANNEL_EXT2) != 0;
+}
+
 void processIROnMessage(JsonDocument &request, JsonDocument &response, AsyncWebSocketClient *wsClient)
 {
     ESP_LOGD(TAG, "Received learn IR on message");
@@ -270,13 +287,62 @@ void processDockMessage(JsonDocument &request, JsonDocument &response, AsyncWebS
     else if (command == "ir_send")
     {
         api_fillDefaultResponseFields(request, response);
-        queueIR(request, response);
+        queueIR(request, response, wsClient);
+    }
+    else if (command == "ir_send_sequence")
+    {
+        api_fillDefaultResponseFields(request, response);
+        queueIRSequence(request, response, wsClient);
+    }
+    else if (command == "ir_send_channels")
+    {
+        api_fillDefaultResponseFields(request, response);
+        queueIRChannels(request, response, wsClient);
     }
     else if (command == "ir_stop")
     {
         api_fillDefaultResponseFields(request, response);
         stopIR(request, response);
     }
+    else if (command == "ir_hold_start")
+    {
+        api_fillDefaultResponseFields(request, response);
+        holdIRStart(request, response, wsClient);
+    }
+    else if (command == "ir_hold_keepalive")
+    {
+        api_fillDefaultResponseFields(request, response);
+        holdIRKeepalive(request, response);
+    }
+    else if (command == "ir_hold_stop")
+    {
+        api_fillDefaultResponseFields(request, response);
+        holdIRStop(request, response);
+    }
+    else if (command == "ir_store")
+    {
+        api_fillDefaultResponseFields(request, response);
+        storeIRCode(request, response);
+    }
+    else if (command == "ir_send_id")
+    {
+        api_fillDefaultResponseFields(request, response);
+        queueIRById(request, response, wsClient);
+    }
+    else if (command == "ir_delete")
+    {
+        api_fillDefaultResponseFields(request, response);
+        deleteIRCode(request, response);
+    }
+    else if (command == "ir_list")
+    {
+        api_fillDefaultResponseFields(request, response);
+        listIRCodes(request, response);
+    }
+    else if (command == "ir_jitter")
+    {
+        reportIRJitter(request, response);
+    }
     else if (command == "ir_receive_on")
     {
         processIROnMessage(request, response, wsClient);
@@ -8,6 +8,7 @@
 #include <Arduino.h>
 #include <AsyncWebSocket.h>
 #include <ArduinoJson.h>
+#include <ir_message.h>
 
 
 void api_processData(JsonDocument &request, JsonDocument &response, AsyncWebSocketClient *wsClient=NULL);
@@ -24,4 +25,6 @@ void api_sendJsonReply(JsonDocument &content, AsyncWebSocketClient *wsClient);
 
 void api_buildIRCodeEvent(JsonDocument &event, String irCode);
 
+void api_buildIRSendDoneEvent(JsonDocument &event, const ir_send_result_t &result);
+
 #endif
\ No newline at end of file
@@ -70,6 +70,55 @@
 #define BLASTER_ENABLE_OTA false
 #endif
 
+// Handling of ir_send requests while the IR output is busy
+#define IR_QUEUE_POLICY_SINGLE 0      // one code at a time; identical codes add repeats, others get 429
+#define IR_QUEUE_POLICY_REJECT_NEWEST 1
+#define IR_QUEUE_POLICY_DROP_OLDEST 2
+#define IR_QUEUE_POLICY_COALESCE 3    // identical to the last queued code adds repeats, otherwise reject newest
+
+#ifndef BLASTER_IR_QUEUE_POLICY
+#define BLASTER_IR_QUEUE_POLICY IR_QUEUE_POLICY_COALESCE
+#endif
+
+// Max number of sends waiting behind the one being transmitted
+#ifndef BLASTER_IR_QUEUE_DEPTH
+#define BLASTER_IR_QUEUE_DEPTH 4
+#endif
+
+// Time a press-and-hold keeps repeating after its last keepalive
+#ifndef BLASTER_IR_HOLD_TIMEOUT_MS
+#define BLASTER_IR_HOLD_TIMEOUT_MS 300
+#endif
+
+// Send timing codes of known protocols (NEC, Samsung, Sony, RC5, RC6) as protocol value
+#ifndef BLASTER_IR_RECOGNIZE_NATIVE
+#define BLASTER_IR_RECOGNIZE_NATIVE true
+#endif
+
+// Timestamp every emitted mark and space and report the timing errors with ir_jitter
+#ifndef BLASTER_ENABLE_IR_JITTER
+#define BLASTER_ENABLE_IR_JITTER false
+#endif
+
+// Marks and spaces stretched by more than this are counted as overruns
+#ifndef BLASTER_IR_JITTER_OVERRUN_US
+#define BLASTER_IR_JITTER_OVERRUN_US 100
+#endif
+
+// Stack sizes of the IR and the web task in bytes. get_sysinfo reports the
+// least free stack of each task since boot (stack_free_bytes).
+#ifndef BLASTER_IR_TASK_STACK
+#define BLASTER_IR_TASK_STACK 32768
+#endif
+
+#ifndef BLASTER_WEB_TASK_STACK
+#define BLASTER_WEB_TASK_STACK 16384
+#endif
+
+// The IR protocols of the firmware are selected by an ir_protocols profile in
+// platformio.ini rather than here: IRremoteESP8266 is a library of its own and
+// only sees the build flags.
+
 
 
 #endif
\ No newline at end of file
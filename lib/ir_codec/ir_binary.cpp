@@ -0,0 +1,553 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_binary.h"
+#include "ir_pronto.h"
+
+#include <string.h>
+
+// Units the durations are counted in
+enum ir_binary_unit {
+    unit_us = 0,      // microseconds
+    unit_pronto = 1,  // pronto carrier periods, whole pronto clock ticks
+    unit_carrier = 2, // exact carrier periods
+};
+
+typedef struct {
+    uint8_t *out;
+    uint16_t length;
+    uint16_t maxLength;
+    bool overflow;
+    uint32_t bits; // packed indices not yet written
+    uint8_t bitCount;
+} ir_byte_writer_t;
+
+// Durations in the order they are encoded, from a raw code or from encoded
+// timings, whose split durations are joined again
+typedef struct {
+    const uint32_t *durations;
+    const uint16_t *timings;
+    uint16_t count;
+    uint16_t pos;
+} ir_duration_reader_t;
+
+// Decoded durations, into a raw code or split into timings
+typedef struct {
+    uint32_t *durations;
+    uint16_t *timings;
+    uint16_t count;
+    uint16_t maxCount;
+} ir_duration_sink_t;
+
+typedef struct {
+    const uint8_t *data;
+    uint16_t length;
+    uint16_t pos;
+} ir_buffer_source_t;
+
+// Length of a unit in microseconds, 16.16 fixed point. 0 if the unit does not
+// fit the carrier.
+static uint32_t unitQ16(uint8_t unit, uint32_t carrierHz)
+{
+    switch (unit)
+    {
+    case unit_us:
+        return 0x10000;
+    case unit_pronto:
+    {
+        if (carrierHz == 0)
+        {
+            return 0;
+        }
+        const uint32_t word = (PRONTO_CLOCK_HZ + carrierHz / 2) / carrierHz;
+        return word == 0 || word > 0xFFFF ? 0 : word * PRONTO_CLOCK_PERIOD_Q16;
+    }
+    case unit_carrier:
+        // periods shorter than a microsecond would only make the counts longer
+        return carrierHz == 0 || carrierHz >= 1000000 ? 0
+                                                      : (uint32_t)((0x10000ULL * 1000000 + carrierHz / 2) / carrierHz);
+    default:
+        return 0;
+    }
+}
+
+static inline uint64_t toUnits(uint32_t durationUs, uint32_t unitQ16)
+{
+    return (((uint64_t)durationUs << 16) + unitQ16 / 2) / unitQ16;
+}
+
+// Rounds like prontoBurstUs(), so pronto codes come back unchanged
+static inline uint64_t toUs(uint64_t units, uint32_t unitQ16)
+{
+    return (units * unitQ16 + 0x8000) >> 16;
+}
+
+static void writeByte(ir_byte_writer_t &w, uint8_t byte)
+{
+    if (w.length >= w.maxLength)
+    {
+        w.overflow = true;
+        return;
+    }
+    w.out[w.length++] = byte;
+}
+
+static void writeVarint(ir_byte_writer_t &w, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        writeByte(w, (value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    writeByte(w, value);
+}
+
+static uint8_t varintSize(uint32_t value)
+{
+    uint8_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Packs `bitCount` bits LSB first
+static void writeBits(ir_byte_writer_t &w, uint32_t value, uint8_t bitCount)
+{
+    w.bits |= value << w.bitCount;
+    w.bitCount += bitCount;
+    while (w.bitCount >= 8)
+    {
+        writeByte(w, w.bits & 0xFF);
+        w.bits >>= 8;
+        w.bitCount -= 8;
+    }
+}
+
+static void flushBits(ir_byte_writer_t &w)
+{
+    if (w.bitCount > 0)
+    {
+        writeByte(w, w.bits & 0xFF);
+    }
+    w.bits = 0;
+    w.bitCount = 0;
+}
+
+static bool readVarint(ir_byte_source_t &source, uint32_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte;
+        if (!source.next(source.context, byte))
+        {
+            return false;
+        }
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t indexBits(uint32_t tableSize)
+{
+    uint8_t bits = 0;
+    while ((1UL << bits) < tableSize)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+// Reads the next duration. Returns false at the end.
+static bool readDuration(ir_duration_reader_t &r, uint32_t &durationUs)
+{
+    if (r.pos >= r.count)
+    {
+        return false;
+    }
+    if (r.durations != NULL)
+    {
+        durationUs = r.durations[r.pos++];
+        return true;
+    }
+    uint16_t last = r.timings[r.pos++];
+    durationUs = last;
+    while (last == IR_TIMING_MAX_US && r.pos + 1 < r.count && r.timings[r.pos] == 0 && r.timings[r.pos + 1] != 0)
+    {
+        last = r.timings[r.pos + 1];
+        durationUs += last;
+        r.pos += 2;
+    }
+    return true;
+}
+
+static bool writeDuration(ir_duration_sink_t &s, uint32_t durationUs)
+{
+    if (s.durations != NULL)
+    {
+        if (s.count >= s.maxCount)
+        {
+            return false;
+        }
+        s.durations[s.count++] = durationUs;
+        return true;
+    }
+    while (durationUs > IR_TIMING_MAX_US)
+    {
+        if (s.count + 2 > s.maxCount)
+        {
+            return false;
+        }
+        s.timings[s.count++] = IR_TIMING_MAX_US;
+        s.timings[s.count++] = 0;
+        durationUs -= IR_TIMING_MAX_US;
+    }
+    if (s.count >= s.maxCount)
+    {
+        return false;
+    }
+    s.timings[s.count++] = durationUs;
+    return true;
+}
+
+// First unit that reproduces every duration, microseconds always do.
+// Returns 0xFF if the durations cannot be encoded: zero durations other than
+// those of split ones, or an odd number of them.
+static uint8_t chooseUnit(ir_duration_reader_t r, uint32_t carrierHz)
+{
+    uint16_t durations = 0;
+    uint32_t durationUs;
+    for (r.pos = 0; readDuration(r, durationUs); durations++)
+    {
+        if (durationUs == 0)
+        {
+            return 0xFF;
+        }
+    }
+    if (durations % 2 != 0)
+    {
+        return 0xFF;
+    }
+
+    static const uint8_t candidates[] = {unit_pronto, unit_carrier};
+    for (uint8_t i = 0; i < sizeof(candidates); i++)
+    {
+        const uint32_t q = unitQ16(candidates[i], carrierHz);
+        if (q == 0)
+        {
+            continue;
+        }
+        bool exact = true;
+        for (r.pos = 0; exact && readDuration(r, durationUs);)
+        {
+            const uint64_t units = toUnits(durationUs, q);
+            exact = units <= 0xFFFFFFFFULL && toUs(units, q) == durationUs;
+        }
+        if (exact)
+        {
+            return candidates[i];
+        }
+    }
+    return unit_us;
+}
+
+// Writes the mark/space pairs, through a table if that is shorter
+static void writePairs(ir_byte_writer_t &w, ir_duration_reader_t r, uint32_t q)
+{
+    uint32_t table[IR_BINARY_MAX_TABLE][2];
+    uint8_t tableSize = 0;
+    bool useTable = true;
+    uint32_t pairs = 0;
+    uint32_t inlineBytes = 0;
+    uint32_t mark, space;
+    for (r.pos = 0; readDuration(r, mark) && readDuration(r, space); pairs++)
+    {
+        mark = toUnits(mark, q);
+        space = toUnits(space, q);
+        inlineBytes += varintSize(mark) + varintSize(space);
+        uint8_t i = 0;
+        while (i < tableSize && (table[i][0] != mark || table[i][1] != space))
+        {
+            i++;
+        }
+        if (i == tableSize && useTable)
+        {
+            if (tableSize == IR_BINARY_MAX_TABLE)
+            {
+                useTable = false;
+                continue;
+            }
+            table[tableSize][0] = mark;
+            table[tableSize][1] = space;
+            tableSize++;
+        }
+    }
+
+    const uint8_t bits = indexBits(tableSize);
+    uint32_t tableBytes = (pairs * bits + 7) / 8;
+    for (uint8_t i = 0; i < tableSize; i++)
+    {
+        tableBytes += varintSize(table[i][0]) + varintSize(table[i][1]);
+    }
+    if (tableBytes >= inlineBytes)
+    {
+        useTable = false;
+    }
+
+    writeVarint(w, pairs);
+    writeVarint(w, useTable ? tableSize : 0);
+    if (!useTable)
+    {
+        for (r.pos = 0; readDuration(r, mark) && readDuration(r, space);)
+        {
+            writeVarint(w, toUnits(mark, q));
+            writeVarint(w, toUnits(space, q));
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < tableSize; i++)
+    {
+        writeVarint(w, table[i][0]);
+        writeVarint(w, table[i][1]);
+    }
+    for (r.pos = 0; readDuration(r, mark) && readDuration(r, space);)
+    {
+        mark = toUnits(mark, q);
+        space = toUnits(space, q);
+        uint8_t i = 0;
+        while (table[i][0] != mark || table[i][1] != space)
+        {
+            i++;
+        }
+        writeBits(w, i, bits);
+    }
+    flushBits(w);
+}
+
+static ir_parse_error readPairs(ir_byte_source_t &source, uint32_t q, ir_duration_sink_t &sink)
+{
+    uint32_t pairs, tableSize;
+    if (!readVarint(source, pairs) || !readVarint(source, tableSize))
+    {
+        return parse_length_mismatch;
+    }
+    if (tableSize > IR_BINARY_MAX_TABLE)
+    {
+        return parse_invalid_header;
+    }
+    uint32_t table[IR_BINARY_MAX_TABLE][2];
+    for (uint8_t i = 0; i < tableSize; i++)
+    {
+        if (!readVarint(source, table[i][0]) || !readVarint(source, table[i][1]))
+        {
+            return parse_length_mismatch;
+        }
+    }
+
+    const uint8_t bits = indexBits(tableSize);
+    uint32_t buffer = 0;
+    uint8_t bufferBits = 0;
+    for (uint32_t p = 0; p < pairs; p++)
+    {
+        uint32_t pair[2];
+        if (tableSize == 0)
+        {
+            if (!readVarint(source, pair[0]) || !readVarint(source, pair[1]))
+            {
+                return parse_length_mismatch;
+            }
+        }
+        else
+        {
+            while (bufferBits < bits)
+            {
+                uint8_t byte;
+                if (!source.next(source.context, byte))
+                {
+                    return parse_length_mismatch;
+                }
+                buffer |= (uint32_t)byte << bufferBits;
+                bufferBits += 8;
+            }
+            const uint32_t i = buffer & ((1UL << bits) - 1);
+            buffer >>= bits;
+            bufferBits -= bits;
+            if (i >= tableSize)
+            {
+                return parse_invalid_header;
+            }
+            pair[0] = table[i][0];
+            pair[1] = table[i][1];
+        }
+        for (uint8_t j = 0; j < 2; j++)
+        {
+            const uint64_t durationUs = toUs(pair[j], q);
+            if (durationUs == 0 || durationUs > 0xFFFFFFFFULL)
+            {
+                return parse_invalid_duration;
+            }
+            if (!writeDuration(sink, durationUs))
+            {
+                return parse_too_long;
+            }
+        }
+    }
+
+    uint8_t extra;
+    return source.next(source.context, extra) ? parse_length_mismatch : parse_ok;
+}
+
+static void writeHeader(ir_byte_writer_t &w, uint32_t carrierHz, uint8_t unit)
+{
+    writeByte(w, IR_BINARY_VERSION);
+    writeVarint(w, carrierHz);
+    writeByte(w, unit);
+}
+
+static ir_parse_error readHeader(ir_byte_source_t &source, uint32_t &carrierHz, uint32_t &q)
+{
+    uint8_t version, unit;
+    if (!source.next(source.context, version) || !readVarint(source, carrierHz) ||
+        !source.next(source.context, unit))
+    {
+        return parse_length_mismatch;
+    }
+    q = unitQ16(unit, carrierHz);
+    return version != IR_BINARY_VERSION || q == 0 ? parse_invalid_header : parse_ok;
+}
+
+uint16_t encodeBinaryRaw(const ir_raw_code_t &raw, uint8_t *out, uint16_t maxLength)
+{
+    const ir_duration_reader_t reader = {raw.durations, NULL, raw.count, 0};
+    const uint8_t unit = chooseUnit(reader, raw.carrierHz);
+    if (unit == 0xFF || raw.repeatStart % 2 != 0 || raw.repeatStart > raw.count)
+    {
+        return 0;
+    }
+    ir_byte_writer_t w = {out, 0, maxLength, false, 0, 0};
+    writeHeader(w, raw.carrierHz, unit);
+    writeVarint(w, raw.repeatStart / 2);
+    writePairs(w, reader, unitQ16(unit, raw.carrierHz));
+    return w.overflow ? 0 : w.length;
+}
+
+ir_parse_error decodeBinaryRaw(ir_byte_source_t &source, ir_raw_code_t &raw)
+{
+    uint32_t q, repeatPairs;
+    ir_parse_error err = readHeader(source, raw.carrierHz, q);
+    if (err != parse_ok)
+    {
+        return err;
+    }
+    if (!readVarint(source, repeatPairs))
+    {
+        return parse_length_mismatch;
+    }
+    ir_duration_sink_t sink = {raw.durations, NULL, 0, raw.maxCount};
+    err = readPairs(source, q, sink);
+    if (err != parse_ok)
+    {
+        return err;
+    }
+    if (repeatPairs * 2 > sink.count)
+    {
+        return parse_invalid_duration;
+    }
+    raw.count = sink.count;
+    raw.repeatStart = repeatPairs * 2;
+    return parse_ok;
+}
+
+uint16_t encodeBinaryTimings(const uint16_t *timings, const ir_timing_layout_t &layout, uint8_t *out,
+                             uint16_t maxLength)
+{
+    const ir_duration_reader_t reader = {NULL, timings, layout.length, 0};
+    const uint8_t unit = chooseUnit(reader, layout.carrierHz);
+    if (unit == 0xFF)
+    {
+        return 0;
+    }
+    ir_byte_writer_t w = {out, 0, maxLength, false, 0, 0};
+    writeHeader(w, layout.carrierHz, unit);
+    writeVarint(w, layout.loopCount);
+    writeVarint(w, layout.repeatLoop);
+    for (uint8_t i = 0; i < layout.loopCount; i++)
+    {
+        writeVarint(w, layout.loops[i].start);
+        writeVarint(w, layout.loops[i].length);
+        writeVarint(w, layout.loops[i].count);
+    }
+    writePairs(w, reader, unitQ16(unit, layout.carrierHz));
+    return w.overflow ? 0 : w.length;
+}
+
+static bool nextBufferByte(void *context, uint8_t &byte)
+{
+    ir_buffer_source_t *s = (ir_buffer_source_t *)context;
+    if (s->pos >= s->length)
+    {
+        return false;
+    }
+    byte = s->data[s->pos++];
+    return true;
+}
+
+ir_parse_error decodeBinaryTimings(const uint8_t *data, uint16_t length, uint16_t *timings, uint16_t maxTimings,
+                                   ir_timing_layout_t &layout)
+{
+    ir_buffer_source_t buffer = {data, length, 0};
+    ir_byte_source_t source = {&buffer, nextBufferByte};
+    uint32_t q, loopCount, repeatLoop;
+    ir_parse_error err = readHeader(source, layout.carrierHz, q);
+    if (err != parse_ok)
+    {
+        return err;
+    }
+    if (!readVarint(source, loopCount) || !readVarint(source, repeatLoop))
+    {
+        return parse_length_mismatch;
+    }
+    if (loopCount > IR_MAX_TIMING_LOOPS || repeatLoop > loopCount)
+    {
+        return parse_invalid_header;
+    }
+    layout.loopCount = loopCount;
+    layout.repeatLoop = repeatLoop;
+    for (uint8_t i = 0; i < loopCount; i++)
+    {
+        uint32_t start, loopLength, count;
+        if (!readVarint(source, start) || !readVarint(source, loopLength) || !readVarint(source, count))
+        {
+            return parse_length_mismatch;
+        }
+        if (start > 0xFFFF || loopLength > 0xFFFF || count > 0xFFFF)
+        {
+            return parse_invalid_header;
+        }
+        layout.loops[i].start = start;
+        layout.loops[i].length = loopLength;
+        layout.loops[i].count = count;
+    }
+
+    ir_duration_sink_t sink = {NULL, timings, 0, maxTimings};
+    err = readPairs(source, q, sink);
+    if (err != parse_ok)
+    {
+        return err;
+    }
+    for (uint8_t i = 0; i < loopCount; i++)
+    {
+        if ((uint32_t)layout.loops[i].start + layout.loops[i].length > sink.count)
+        {
+            return parse_invalid_header;
+        }
+    }
+    layout.length = sink.count;
+    return parse_ok;
+}
@@ -0,0 +1,48 @@
+// Copyright 2024 Craig Petchell
+
+// Compact binary form of timing based codes, used by the code store and as
+// code format "binary" (base64). Durations are counted in a unit the code was
+// made of (pronto or carrier periods, else microseconds) and written as
+// varints. If the code is built from a few distinct mark/space pairs, as
+// protocol codes are, the pairs go into a table and the code refers to them
+// by packed indices. The encoding is lossless: a unit is only used if it
+// reproduces every duration exactly.
+//
+//   version, carrier Hz, unit, section info (repeat start or loops),
+//   pair count, table size (0 = no table), table or pairs, packed indices
+
+#ifndef IR_BINARY_H_
+#define IR_BINARY_H_
+
+#include <stdint.h>
+#include "ir_parse_error.h"
+#include "ir_timing.h"
+
+#define IR_BINARY_VERSION 1
+// Most distinct pairs kept in a table, more are written inline
+#define IR_BINARY_MAX_TABLE 32
+// Room needed to encode `timings` timings in the worst case
+#define IR_BINARY_MAX_SIZE(timings) (160 + 5 * (uint32_t)(timings))
+
+// Reads the encoded bytes one by one
+typedef struct {
+    void *context;
+    bool (*next)(void *context, uint8_t &byte); // false at the end of the data
+} ir_byte_source_t;
+
+// Encodes a raw code. Returns the bytes written, 0 if they do not fit into
+// maxLength or the code has an odd number of durations.
+uint16_t encodeBinaryRaw(const ir_raw_code_t &raw, uint8_t *out, uint16_t maxLength);
+
+// Decodes into `raw`, which brings the buffer for the durations.
+ir_parse_error decodeBinaryRaw(ir_byte_source_t &source, ir_raw_code_t &raw);
+
+// Encodes timings as encodeTimings() produced them, loops included. Returns
+// the bytes written, 0 if they do not fit into maxLength.
+uint16_t encodeBinaryTimings(const uint16_t *timings, const ir_timing_layout_t &layout, uint8_t *out,
+                             uint16_t maxLength);
+
+ir_parse_error decodeBinaryTimings(const uint8_t *data, uint16_t length, uint16_t *timings, uint16_t maxTimings,
+                                   ir_timing_layout_t &layout);
+
+#endif
@@ -0,0 +1,146 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_capture.h"
+
+#include <string.h>
+
+IrCaptureTransmitter::IrCaptureTransmitter(ir_capture_event_t *events, uint16_t maxEvents)
+    : events(events), maxEvents(maxEvents), carrierHz(0), channels(0)
+{
+    clear();
+}
+
+void IrCaptureTransmitter::clear()
+{
+    count = 0;
+    overflow = false;
+    frameCount = 0;
+}
+
+ir_capture_event_t *IrCaptureTransmitter::append(uint8_t kind)
+{
+    if (count >= maxEvents)
+    {
+        overflow = true;
+        return NULL;
+    }
+    ir_capture_event_t *event = &events[count++];
+    memset(event, 0, sizeof(ir_capture_event_t));
+    event->kind = kind;
+    return event;
+}
+
+void IrCaptureTransmitter::burst(uint8_t kind, uint32_t durationUs)
+{
+    if (count > 0 && !overflow)
+    {
+        ir_capture_event_t &last = events[count - 1];
+        if (last.kind == kind &&
+            (kind == capture_space || (last.carrierHz == carrierHz && last.channels == channels)))
+        {
+            last.durationUs += durationUs;
+            return;
+        }
+    }
+    ir_capture_event_t *event = append(kind);
+    if (event != NULL)
+    {
+        event->durationUs = durationUs;
+        if (kind == capture_mark)
+        {
+            event->carrierHz = carrierHz;
+            event->channels = channels;
+        }
+    }
+}
+
+void IrCaptureTransmitter::enableIROut(uint32_t hz)
+{
+    carrierHz = hz;
+}
+
+void IrCaptureTransmitter::setChannels(uint8_t outputs)
+{
+    channels = outputs;
+}
+
+void IrCaptureTransmitter::mark(uint32_t durationUs)
+{
+    burst(capture_mark, durationUs);
+}
+
+void IrCaptureTransmitter::space(uint32_t durationUs)
+{
+    burst(capture_space, durationUs);
+}
+
+bool IrCaptureTransmitter::sendValue(int16_t decodeType, uint64_t value, uint16_t bits, uint16_t repeats)
+{
+    ir_capture_event_t *event = append(capture_value);
+    if (event != NULL)
+    {
+        event->decodeType = decodeType;
+        event->value = value;
+        event->bits = bits;
+        event->repeats = repeats;
+    }
+    return true;
+}
+
+bool IrCaptureTransmitter::sendState(int16_t decodeType, const uint8_t *, uint16_t length)
+{
+    ir_capture_event_t *event = append(capture_state);
+    if (event != NULL)
+    {
+        event->decodeType = decodeType;
+        event->bits = length;
+    }
+    return true;
+}
+
+void IrCaptureTransmitter::beginFrame()
+{
+    frameCount++;
+}
+
+uint16_t IrCaptureTransmitter::timeline(uint32_t *out, uint16_t maxOut) const
+{
+    uint16_t length = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const ir_capture_event_t &event = events[i];
+        if (event.kind != capture_mark && event.kind != capture_space)
+        {
+            continue;
+        }
+        // a leading space, or marks on other outputs back to back, get an
+        // empty burst in between, so positions keep alternating
+        if ((length & 1) != (event.kind == capture_space))
+        {
+            if (length >= maxOut)
+            {
+                return 0;
+            }
+            out[length++] = 0;
+        }
+        if (length >= maxOut)
+        {
+            return 0;
+        }
+        out[length++] = event.durationUs;
+    }
+    return length;
+}
+
+uint64_t IrCaptureTransmitter::durationUs() const
+{
+    uint64_t total = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (events[i].kind == capture_mark || events[i].kind == capture_space)
+        {
+            total += events[i].durationUs;
+        }
+    }
+    return total;
+}
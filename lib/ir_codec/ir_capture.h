@@ -0,0 +1,75 @@
+// Copyright 2024 Craig Petchell
+
+// Transmitter backend that records what would have been sent, so the send
+// path runs in native tests and benchmarks. Consecutive spaces, and marks on
+// the same carrier and outputs, are recorded as one event, as they are one
+// burst on the pins.
+
+#ifndef IR_CAPTURE_H_
+#define IR_CAPTURE_H_
+
+#include <stdint.h>
+#include "ir_transmitter.h"
+
+enum ir_capture_kind {
+    capture_mark = 0,
+    capture_space,
+    capture_value, // protocol value, encoded by the backend on the dock
+    capture_state, // state of an AC protocol
+};
+
+typedef struct {
+    uint8_t kind;        // ir_capture_kind
+    uint8_t channels;    // marks: outputs driven
+    uint32_t carrierHz;  // marks
+    uint32_t durationUs; // marks and spaces
+    int16_t decodeType;  // values and states
+    uint64_t value;      // values
+    uint16_t bits;       // values: bits, states: bytes
+    uint16_t repeats;    // values
+} ir_capture_event_t;
+
+class IrCaptureTransmitter : public IrTransmitter
+{
+public:
+    // Records into `events`; events beyond maxEvents are dropped and
+    // overflowed() reports it.
+    IrCaptureTransmitter(ir_capture_event_t *events, uint16_t maxEvents);
+
+    void enableIROut(uint32_t carrierHz) override;
+    void setChannels(uint8_t channels) override;
+    void mark(uint32_t durationUs) override;
+    void space(uint32_t durationUs) override;
+    bool sendValue(int16_t decodeType, uint64_t value, uint16_t bits, uint16_t repeats) override;
+    bool sendState(int16_t decodeType, const uint8_t *state, uint16_t length) override;
+    void beginFrame() override;
+
+    void clear();
+
+    uint16_t size() const { return count; }
+    const ir_capture_event_t &at(uint16_t index) const { return events[index]; }
+    bool overflowed() const { return overflow; }
+    uint16_t frames() const { return frameCount; }
+
+    // Marks and spaces since clear(), alternating and starting with a mark,
+    // as expandTimings() writes them. Returns the number of durations, 0 if
+    // they do not fit into maxOut.
+    uint16_t timeline(uint32_t *out, uint16_t maxOut) const;
+
+    // Length of the recorded marks and spaces
+    uint64_t durationUs() const;
+
+private:
+    ir_capture_event_t *events;
+    uint16_t maxEvents;
+    uint16_t count;
+    bool overflow;
+    uint16_t frameCount;
+    uint32_t carrierHz;
+    uint8_t channels;
+
+    ir_capture_event_t *append(uint8_t kind);
+    void burst(uint8_t kind, uint32_t durationUs);
+};
+
+#endif
@@ -0,0 +1,433 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_code_log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define IR_LOG_BANK_MAGIC 0x53435249UL   // "IRCS"
+#define IR_LOG_RECORD_MAGIC 0x52435249UL // "IRCR"
+#define IR_LOG_VERSION 1
+#define IR_LOG_ERASED 0xFFFFFFFFUL
+// Record flag: the code with this id was deleted
+#define IR_LOG_DELETED 0x01
+// Records are copied between the banks through a buffer of this size
+#define IR_LOG_COPY_CHUNK 64
+
+#define FNV32_OFFSET_BASIS 0x811c9dc5UL
+#define FNV32_PRIME 0x01000193UL
+
+// Start of a bank, followed by the records
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t generation; // the valid bank with the higher generation is the active one
+    uint32_t checksum;   // over version and generation
+} ir_log_bank_t;
+
+// Record header, followed by the name with terminator and the payload, each
+// padded to 4 bytes
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum; // over the fields below, name and payload
+    uint16_t id;
+    uint16_t length;   // payload bytes
+    uint8_t nameLength;
+    uint8_t flags;
+    uint16_t reserved;
+} ir_log_record_t;
+
+const char *irStoreErrorToString(ir_store_error error)
+{
+    switch (error)
+    {
+    case store_ok:
+        return "OK";
+    case store_unavailable:
+        return "IR code store not available";
+    case store_not_found:
+        return "IR code not found";
+    case store_full:
+        return "IR code store is full";
+    case store_invalid_name:
+        return "Name of IR code too long";
+    case store_name_taken:
+        return "Name already used by another IR code";
+    case store_too_large:
+        return "IR code too large for the code store";
+    case store_flash_error:
+        return "Writing the IR code store failed";
+    default:
+        return "Unknown error";
+    }
+}
+
+static uint32_t checksum(uint32_t hash, const void *data, uint32_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+static inline uint32_t align4(uint32_t length)
+{
+    return (length + 3) & ~3UL;
+}
+
+static uint32_t recordSize(const ir_log_record_t &record)
+{
+    return sizeof(ir_log_record_t) + align4(record.nameLength + 1) + align4(record.length);
+}
+
+static uint32_t recordChecksum(const ir_log_record_t &record, const char *name, const uint8_t *payload)
+{
+    uint32_t hash = checksum(FNV32_OFFSET_BASIS, &record.id, sizeof(ir_log_record_t) - offsetof(ir_log_record_t, id));
+    hash = checksum(hash, name, record.nameLength + 1);
+    return checksum(hash, payload, record.length);
+}
+
+static uint32_t bankChecksum(const ir_log_bank_t &header)
+{
+    return checksum(FNV32_OFFSET_BASIS, &header.version, 2 * sizeof(uint32_t));
+}
+
+IrCodeLog::IrCodeLog(const uint8_t *flash, uint32_t size, const ir_flash_ops_t &ops)
+    : flash(flash), bankSize((size / 2) & ~(uint32_t)(IR_LOG_SECTOR_SIZE - 1)), ops(ops), bank(0), generation(0),
+      tail(0), count(0), ready(false)
+{
+}
+
+ir_store_error IrCodeLog::begin()
+{
+    ready = false;
+    count = 0;
+    if (flash == NULL || bankSize == 0)
+    {
+        return store_unavailable;
+    }
+
+    bool valid[2];
+    uint32_t generations[2];
+    for (uint8_t number = 0; number < 2; number++)
+    {
+        const ir_log_bank_t *header = (const ir_log_bank_t *)bankStart(number);
+        valid[number] = header->magic == IR_LOG_BANK_MAGIC && header->version == IR_LOG_VERSION &&
+                        header->checksum == bankChecksum(*header);
+        generations[number] = header->generation;
+    }
+    if (!valid[0] && !valid[1])
+    {
+        const ir_store_error err = format(0, 1);
+        ready = err == store_ok;
+        return err;
+    }
+    // the generation may wrap, the newer bank is the one just ahead of the other
+    bank = (!valid[0] || (valid[1] && (int32_t)(generations[1] - generations[0]) > 0)) ? 1 : 0;
+    generation = generations[bank];
+    scan();
+    ready = true;
+    return store_ok;
+}
+
+void IrCodeLog::scan()
+{
+    count = 0;
+    const uint8_t *start = bankStart(bank);
+    uint32_t offset = sizeof(ir_log_bank_t);
+    while (offset + sizeof(ir_log_record_t) <= bankSize)
+    {
+        const ir_log_record_t *record = (const ir_log_record_t *)(start + offset);
+        if (record->magic == IR_LOG_ERASED)
+        {
+            break;
+        }
+        const uint32_t size = recordSize(*record);
+        if (record->magic != IR_LOG_RECORD_MAGIC || offset + size > bankSize)
+        {
+            // nothing after this can be trusted, the next put compacts
+            offset = bankSize;
+            break;
+        }
+        const char *name = (const char *)(record + 1);
+        const uint8_t *payload = (const uint8_t *)name + align4(record->nameLength + 1);
+        // records torn by a reset are skipped, the previous version of the code stays
+        if (record->checksum == recordChecksum(*record, name, payload))
+        {
+            apply(record->id, record->flags & IR_LOG_DELETED, offset);
+        }
+        offset += size;
+    }
+    // an interrupted write may have left bytes behind the last record
+    for (uint32_t free = offset; free < bankSize; free += sizeof(uint32_t))
+    {
+        if (*(const uint32_t *)(start + free) != IR_LOG_ERASED)
+        {
+            offset = bankSize;
+            break;
+        }
+    }
+    tail = offset;
+}
+
+void IrCodeLog::apply(uint16_t id, bool deleted, uint32_t offset)
+{
+    const int16_t i = indexOf(id);
+    if (deleted)
+    {
+        if (i >= 0)
+        {
+            index[i] = index[--count];
+        }
+    }
+    else if (i >= 0)
+    {
+        index[i].offset = offset;
+    }
+    else if (count < IR_LOG_MAX_CODES)
+    {
+        index[count].id = id;
+        index[count].offset = offset;
+        count++;
+    }
+}
+
+ir_store_error IrCodeLog::format(uint8_t number, uint32_t newGeneration)
+{
+    ir_log_bank_t header = {IR_LOG_BANK_MAGIC, IR_LOG_VERSION, newGeneration, 0};
+    header.checksum = bankChecksum(header);
+    if (!ops.erase(ops.context, number * bankSize, bankSize) ||
+        !ops.write(ops.context, number * bankSize, &header, sizeof(header)))
+    {
+        return store_flash_error;
+    }
+    bank = number;
+    generation = newGeneration;
+    count = 0;
+    tail = sizeof(ir_log_bank_t);
+    return store_ok;
+}
+
+int16_t IrCodeLog::indexOf(uint16_t id) const
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (index[i].id == id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int16_t IrCodeLog::indexOfName(const char *name) const
+{
+    const uint8_t *start = bankStart(bank);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (strcmp(name, (const char *)(start + index[i].offset + sizeof(ir_log_record_t))) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint16_t IrCodeLog::nextFreeId() const
+{
+    uint16_t highest = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (index[i].id > highest)
+        {
+            highest = index[i].id;
+        }
+    }
+    if (highest < 0xFFFF)
+    {
+        return highest + 1;
+    }
+    for (uint16_t id = 1; id < 0xFFFF; id++)
+    {
+        if (indexOf(id) < 0)
+        {
+            return id;
+        }
+    }
+    return IR_LOG_NO_ID;
+}
+
+void IrCodeLog::entryAt(uint16_t i, ir_log_entry_t &entry) const
+{
+    const ir_log_record_t *record = (const ir_log_record_t *)(bankStart(bank) + index[i].offset);
+    entry.id = record->id;
+    entry.name = (const char *)(record + 1);
+    entry.payload = (const uint8_t *)entry.name + align4(record->nameLength + 1);
+    entry.length = record->length;
+    entry.checksum = record->checksum;
+}
+
+bool IrCodeLog::find(uint16_t id, ir_log_entry_t &entry) const
+{
+    const int16_t i = indexOf(id);
+    if (i < 0)
+    {
+        return false;
+    }
+    entryAt(i, entry);
+    return true;
+}
+
+bool IrCodeLog::findName(const char *name, ir_log_entry_t &entry) const
+{
+    const int16_t i = indexOfName(name);
+    if (i < 0)
+    {
+        return false;
+    }
+    entryAt(i, entry);
+    return true;
+}
+
+bool IrCodeLog::at(uint16_t i, ir_log_entry_t &entry) const
+{
+    if (i >= count)
+    {
+        return false;
+    }
+    entryAt(i, entry);
+    return true;
+}
+
+ir_store_error IrCodeLog::put(uint16_t &id, const char *name, const uint8_t *payload, uint16_t length)
+{
+    if (!ready)
+    {
+        return store_unavailable;
+    }
+    if (name == NULL)
+    {
+        name = "";
+    }
+    if (strlen(name) > IR_LOG_MAX_NAME)
+    {
+        return store_invalid_name;
+    }
+    ir_log_record_t record = {0, 0, 0, length, (uint8_t)strlen(name), 0, 0};
+    if (sizeof(ir_log_bank_t) + recordSize(record) > bankSize)
+    {
+        return store_too_large;
+    }
+
+    const int16_t named = name[0] != '\0' ? indexOfName(name) : -1;
+    if (id == IR_LOG_NO_ID)
+    {
+        id = named >= 0 ? index[named].id : nextFreeId();
+        if (id == IR_LOG_NO_ID)
+        {
+            return store_full;
+        }
+    }
+    else if (named >= 0 && index[named].id != id)
+    {
+        return store_name_taken;
+    }
+    if (indexOf(id) < 0 && count >= IR_LOG_MAX_CODES)
+    {
+        return store_full;
+    }
+    return append(id, name, 0, payload, length);
+}
+
+ir_store_error IrCodeLog::remove(uint16_t id)
+{
+    if (!ready)
+    {
+        return store_unavailable;
+    }
+    if (indexOf(id) < 0)
+    {
+        return store_not_found;
+    }
+    return append(id, "", IR_LOG_DELETED, NULL, 0);
+}
+
+ir_store_error IrCodeLog::append(uint16_t id, const char *name, uint8_t flags, const uint8_t *payload, uint16_t length)
+{
+    ir_log_record_t record = {IR_LOG_RECORD_MAGIC, 0, id, length, (uint8_t)strlen(name), flags, 0xFFFF};
+    const uint32_t size = recordSize(record);
+    if (tail + size > bankSize)
+    {
+        const ir_store_error err = compact();
+        if (err != store_ok)
+        {
+            return err;
+        }
+        if (tail + size > bankSize)
+        {
+            return store_full;
+        }
+    }
+    record.checksum = recordChecksum(record, name, payload);
+
+    // the header goes first: a reset before the rest is written leaves a
+    // record of known size that fails its checksum
+    const uint32_t offset = bank * bankSize + tail;
+    const uint32_t nameOffset = offset + sizeof(ir_log_record_t);
+    if (!ops.write(ops.context, offset, &record, sizeof(record)) ||
+        !ops.write(ops.context, nameOffset, name, record.nameLength + 1) ||
+        (length > 0 && !ops.write(ops.context, nameOffset + align4(record.nameLength + 1), payload, length)))
+    {
+        // whatever made it to the flash is skipped by the next scan
+        tail = bankSize;
+        return store_flash_error;
+    }
+    apply(id, flags & IR_LOG_DELETED, tail);
+    tail += size;
+    return store_ok;
+}
+
+ir_store_error IrCodeLog::compact()
+{
+    const uint8_t target = bank ^ 1;
+    const uint32_t targetOffset = target * bankSize;
+    if (!ops.erase(ops.context, targetOffset, bankSize))
+    {
+        return store_flash_error;
+    }
+
+    // the flash may not be written from the mapped flash itself
+    uint8_t chunk[IR_LOG_COPY_CHUNK];
+    const uint8_t *start = bankStart(bank);
+    uint32_t offset = sizeof(ir_log_bank_t);
+    bool ok = true;
+    for (uint16_t i = 0; i < count && ok; i++)
+    {
+        const uint8_t *record = start + index[i].offset;
+        const uint32_t size = recordSize(*(const ir_log_record_t *)record);
+        for (uint32_t copied = 0; copied < size && ok; copied += IR_LOG_COPY_CHUNK)
+        {
+            const uint32_t part = size - copied < IR_LOG_COPY_CHUNK ? size - copied : IR_LOG_COPY_CHUNK;
+            memcpy(chunk, record + copied, part);
+            ok = ops.write(ops.context, targetOffset + offset + copied, chunk, part);
+        }
+        index[i].offset = offset;
+        offset += size;
+    }
+
+    // the bank header makes the copy the active bank, so it is written last
+    ir_log_bank_t header = {IR_LOG_BANK_MAGIC, IR_LOG_VERSION, generation + 1, 0};
+    header.checksum = bankChecksum(header);
+    if (!ok || !ops.write(ops.context, targetOffset, &header, sizeof(header)))
+    {
+        // back to the records of the old bank
+        scan();
+        return store_flash_error;
+    }
+    bank = target;
+    generation++;
+    tail = offset;
+    return store_ok;
+}
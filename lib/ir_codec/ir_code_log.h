@@ -0,0 +1,111 @@
+// Copyright 2024 Craig Petchell
+
+// Append-only log of named IR codes in a flash area. The area is split into
+// two banks; records are only ever appended to the active bank, replacing and
+// deleting a code appends a newer record. When the bank is full, the live
+// records are copied to the other bank, which then becomes the active one.
+// Reads go straight to the memory mapped flash, the index of the live records
+// is kept in RAM and rebuilt from the log on start.
+
+#ifndef IR_CODE_LOG_H_
+#define IR_CODE_LOG_H_
+
+#include <stdint.h>
+
+// Erase unit of the flash, banks are a multiple of it
+#define IR_LOG_SECTOR_SIZE 4096
+#define IR_LOG_MAX_CODES 256
+// Longest code name, without terminator
+#define IR_LOG_MAX_NAME 31
+// Lets put() choose the id
+#define IR_LOG_NO_ID 0
+
+enum ir_store_error {
+    store_ok = 0,
+    store_unavailable,  // no flash area for the code store
+    store_not_found,    // no code with this id or name
+    store_full,         // no room left after compaction, or no free id
+    store_invalid_name, // name longer than IR_LOG_MAX_NAME
+    store_name_taken,   // name belongs to a code with another id
+    store_too_large,    // code does not fit into a bank
+    store_flash_error,  // writing or erasing the flash failed
+};
+
+const char *irStoreErrorToString(ir_store_error error);
+
+// Writes and erases the flash area; offsets are relative to its start
+typedef struct {
+    void *context;
+    bool (*write)(void *context, uint32_t offset, const void *data, uint32_t length);
+    bool (*erase)(void *context, uint32_t offset, uint32_t length);
+} ir_flash_ops_t;
+
+// A stored code. The pointers point into the mapped flash and stay valid
+// until the log is changed.
+typedef struct {
+    uint16_t id;
+    const char *name;
+    const uint8_t *payload;
+    uint16_t length;
+    uint32_t checksum; // differs between the stored versions of a code
+} ir_log_entry_t;
+
+class IrCodeLog
+{
+public:
+    // `flash` maps the whole area of `size` bytes for reading.
+    IrCodeLog(const uint8_t *flash, uint32_t size, const ir_flash_ops_t &ops);
+
+    // Finds the active bank and indexes its records. Formats the area if
+    // neither bank is valid.
+    ir_store_error begin();
+
+    // Stores `payload` under `id`, replacing the code with this id. With
+    // IR_LOG_NO_ID the code replaces the one of the same name, or gets the
+    // next free id; the id used is returned in `id`. `name` may be empty.
+    ir_store_error put(uint16_t &id, const char *name, const uint8_t *payload, uint16_t length);
+
+    ir_store_error remove(uint16_t id);
+
+    bool find(uint16_t id, ir_log_entry_t &entry) const;
+    bool findName(const char *name, ir_log_entry_t &entry) const;
+
+    // Stored code number `index`, 0 <= index < size()
+    bool at(uint16_t index, ir_log_entry_t &entry) const;
+
+    uint16_t size() const { return count; }
+
+    // Bytes of the active bank taken by records, including replaced ones
+    uint32_t bytesUsed() const { return tail; }
+    uint32_t capacity() const { return bankSize; }
+
+private:
+    typedef struct {
+        uint16_t id;
+        uint32_t offset; // of the record in the active bank
+    } ir_log_index_t;
+
+    const uint8_t *flash;
+    uint32_t bankSize;
+    ir_flash_ops_t ops;
+    uint8_t bank;
+    uint32_t generation;
+    uint32_t tail;
+    uint16_t count;
+    bool ready; // begin() succeeded
+    ir_log_index_t index[IR_LOG_MAX_CODES];
+
+    const uint8_t *bankStart(uint8_t number) const { return flash + number * bankSize; }
+    int16_t indexOf(uint16_t id) const;
+    int16_t indexOfName(const char *name) const;
+    uint16_t nextFreeId() const;
+    void entryAt(uint16_t i, ir_log_entry_t &entry) const;
+
+    void scan();
+    void apply(uint16_t id, bool deleted, uint32_t offset);
+    ir_store_error format(uint8_t number, uint32_t newGeneration);
+    ir_store_error append(uint16_t id, const char *name, uint8_t flags, const uint8_t *payload, uint16_t length);
+    ir_store_error compact();
+};
+
+#endif
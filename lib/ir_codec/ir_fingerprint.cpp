@@ -0,0 +1,64 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_fingerprint.h"
+
+#include <string.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static inline uint64_t fnvAdd(uint64_t hash, uint8_t c)
+{
+    return (hash ^ c) * FNV_PRIME;
+}
+
+static inline bool isCodeSeparator(char c)
+{
+    return c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline uint8_t foldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c | 0x20) : (uint8_t)c;
+}
+
+static uint64_t hashNormalized(uint64_t hash, const char *str, bool ignoreCase)
+{
+    bool pendingSeparator = false;
+    bool started = false;
+    for (; *str; str++)
+    {
+        if (isCodeSeparator(*str))
+        {
+            // emit separators lazily, so leading and trailing ones are dropped
+            pendingSeparator = started;
+            continue;
+        }
+        if (pendingSeparator)
+        {
+            hash = fnvAdd(hash, ' ');
+            pendingSeparator = false;
+        }
+        hash = fnvAdd(hash, ignoreCase ? foldCase(*str) : (uint8_t)*str);
+        started = true;
+    }
+    return hash;
+}
+
+uint64_t irCodeFingerprint(const char *format, const char *code)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    if (format)
+    {
+        hash = hashNormalized(hash, format, true);
+    }
+    // terminate the format so ("ab", "c") and ("a", "bc") differ
+    hash = fnvAdd(hash, 0);
+    if (code)
+    {
+        // base64 codes differ in the case of their letters
+        const bool base64 = format != NULL && (strcmp(format, "broadlink") == 0 || strcmp(format, "binary") == 0);
+        hash = hashNormalized(hash, code, !base64);
+    }
+    return hash ? hash : 1;
+}
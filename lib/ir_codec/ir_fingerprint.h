@@ -0,0 +1,17 @@
+// Copyright 2024 Craig Petchell
+
+// Fast fingerprint of textual IR codes, used to recognize codes sent before.
+
+#ifndef IR_FINGERPRINT_H_
+#define IR_FINGERPRINT_H_
+
+#include <stdint.h>
+
+// 64 bit FNV-1a hash over the normalized (format, code) pair. Normalization
+// ignores the case of letters (except in base64 broadlink and binary codes) and
+// treats every run of spaces, commas, tabs and line breaks as a single separator, so
+// differently formatted variants of the same code share one fingerprint.
+// Never returns 0, which marks "no code".
+uint64_t irCodeFingerprint(const char *format, const char *code);
+
+#endif
@@ -0,0 +1,614 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_formats.h"
+#include "ir_binary.h"
+#include "ir_pronto.h"
+#include "ir_timeline.h"
+
+#include <string.h>
+
+#define GC_SENDIR_PREFIX "sendir,"
+#define GC_MIN_CARRIER_HZ 15000
+#define GC_MAX_CARRIER_HZ 500000
+
+#define BROADLINK_IR_PACKET 0x26
+#define BROADLINK_HEADER_BYTES 4
+// Broadlink ticks are 269/8192 ms
+#define BROADLINK_TICK_NUM 269000ULL
+#define BROADLINK_TICK_DEN 8192ULL
+
+static const char kBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static inline bool isCodeDelimiter(char c)
+{
+    return c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Reads a decimal number and the delimiters after it.
+static bool readDecimal(const char *&ptr, uint32_t &value)
+{
+    const char *start = ptr;
+    value = 0;
+    while (*ptr >= '0' && *ptr <= '9')
+    {
+        if (value > 99999999)
+        {
+            return false;
+        }
+        value = value * 10 + (*ptr++ - '0');
+    }
+    if (ptr == start)
+    {
+        return false;
+    }
+    while (isCodeDelimiter(*ptr))
+    {
+        ptr++;
+    }
+    return true;
+}
+
+static bool appendDuration(ir_raw_code_t &raw, uint32_t durationUs)
+{
+    if (raw.count >= raw.maxCount)
+    {
+        return false;
+    }
+    raw.durations[raw.count++] = durationUs;
+    return true;
+}
+
+// Codes that end with a mark get a gap, so repeats do not run into each other.
+static ir_parse_error finishWithoutRepeatSection(ir_raw_code_t &raw)
+{
+    if (raw.count == 0)
+    {
+        return parse_empty;
+    }
+    if ((raw.count & 1) && !appendDuration(raw, IR_RAW_TRAILING_GAP_US))
+    {
+        return parse_too_long;
+    }
+    // the whole code is sent again for every repeat
+    raw.repeatStart = 0;
+    return parse_ok;
+}
+
+typedef struct {
+    char *text;
+    uint16_t length;
+    uint16_t maxLength;
+} ir_text_writer_t;
+
+static bool writeChar(ir_text_writer_t &w, char c)
+{
+    if (w.length + 1 >= w.maxLength)
+    {
+        return false;
+    }
+    w.text[w.length++] = c;
+    w.text[w.length] = 0;
+    return true;
+}
+
+static bool writeString(ir_text_writer_t &w, const char *str)
+{
+    while (*str)
+    {
+        if (!writeChar(w, *str++))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool writeDecimal(ir_text_writer_t &w, uint32_t value)
+{
+    char digits[10];
+    uint8_t count = 0;
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    while (count > 0)
+    {
+        if (!writeChar(w, digits[--count]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool writeHexWord(ir_text_writer_t &w, uint16_t value)
+{
+    static const char kHexChars[] = "0123456789ABCDEF";
+    for (int8_t shift = 12; shift >= 0; shift -= 4)
+    {
+        if (!writeChar(w, kHexChars[(value >> shift) & 0xF]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ir_text_writer_t textWriter(char *text, uint16_t maxLength)
+{
+    ir_text_writer_t w = {text, 0, maxLength};
+    if (maxLength > 0)
+    {
+        text[0] = 0;
+    }
+    return w;
+}
+
+static ir_parse_error parsePronto(const char *code, ir_raw_code_t &raw)
+{
+    // the words go to the upper half of the duration buffer; converting them
+    // front to back never overwrites a word before it is read
+    uint16_t *words = (uint16_t *)raw.durations + raw.maxCount;
+    uint16_t wordCount = 0;
+    const ir_parse_error err = parseProntoCode(code, words, raw.maxCount, wordCount);
+    if (err != parse_ok)
+    {
+        return err;
+    }
+
+    const uint32_t periodQ16 = prontoPeriodQ16(words);
+    raw.carrierHz = prontoCarrierHz(words);
+    raw.repeatStart = 2 * words[PRONTO_ONCE_OFFSET];
+    raw.count = wordCount - PRONTO_HEADER_WORDS;
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        raw.durations[i] = prontoBurstUs(words[PRONTO_HEADER_WORDS + i], periodQ16);
+    }
+    return parse_ok;
+}
+
+static bool formatPronto(const ir_raw_code_t &raw, char *text, uint16_t maxLength)
+{
+    if (raw.carrierHz == 0 || (raw.repeatStart & 1))
+    {
+        return false;
+    }
+    const uint32_t frequency = (PRONTO_CLOCK_HZ + raw.carrierHz / 2) / raw.carrierHz;
+    const uint64_t periodPs = frequency * PRONTO_CLOCK_PERIOD_PS;
+    const uint16_t header[PRONTO_HEADER_WORDS] = {0, (uint16_t)frequency, (uint16_t)(raw.repeatStart / 2),
+                                                  (uint16_t)((raw.count - raw.repeatStart) / 2)};
+
+    ir_text_writer_t w = textWriter(text, maxLength);
+    for (uint8_t i = 0; i < PRONTO_HEADER_WORDS; i++)
+    {
+        if ((i > 0 && !writeChar(w, ' ')) || !writeHexWord(w, header[i]))
+        {
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        const uint64_t periods = ((uint64_t)raw.durations[i] * 1000000 + periodPs / 2) / periodPs;
+        if (periods > 0xFFFF || !writeChar(w, ' ') || !writeHexWord(w, (uint16_t)periods))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ir_parse_error parseRaw(const char *code, ir_raw_code_t &raw)
+{
+    const char *ptr = code;
+    raw.carrierHz = IR_RAW_DEFAULT_CARRIER_HZ;
+    raw.count = 0;
+    if (strchr(code, ';') != NULL)
+    {
+        uint32_t carrierHz;
+        if (!readDecimal(ptr, carrierHz) || *ptr != ';')
+        {
+            return parse_invalid_header;
+        }
+        if (carrierHz < GC_MIN_CARRIER_HZ || carrierHz > GC_MAX_CARRIER_HZ)
+        {
+            return parse_invalid_duration;
+        }
+        raw.carrierHz = carrierHz;
+        ptr++;
+    }
+
+    while (isCodeDelimiter(*ptr))
+    {
+        ptr++;
+    }
+    while (*ptr)
+    {
+        uint32_t durationUs;
+        if (!readDecimal(ptr, durationUs))
+        {
+            return parse_invalid_char;
+        }
+        if (durationUs == 0)
+        {
+            return parse_invalid_duration;
+        }
+        if (!appendDuration(raw, durationUs))
+        {
+            return parse_too_long;
+        }
+    }
+    return finishWithoutRepeatSection(raw);
+}
+
+static bool formatRaw(const ir_raw_code_t &raw, char *text, uint16_t maxLength)
+{
+    ir_text_writer_t w = textWriter(text, maxLength);
+    if (!writeDecimal(w, raw.carrierHz) || !writeChar(w, ';'))
+    {
+        return false;
+    }
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        if ((i > 0 && !writeChar(w, ',')) || !writeDecimal(w, raw.durations[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// sendir,<module>:<connector>,<id>,<frequency>,<repeat>,<offset>,<on1>,<off1>,...
+// durations count carrier periods, offset is the 1 based start of the repeat section
+static ir_parse_error parseGlobalCache(const char *code, ir_raw_code_t &raw)
+{
+    if (strncmp(code, GC_SENDIR_PREFIX, strlen(GC_SENDIR_PREFIX)) != 0)
+    {
+        return parse_invalid_header;
+    }
+    // module:connector and id address outputs of the iTach
+    const char *ptr = code + strlen(GC_SENDIR_PREFIX);
+    for (uint8_t field = 0; field < 2; field++)
+    {
+        ptr = strchr(ptr, ',');
+        if (ptr == NULL)
+        {
+            return parse_invalid_header;
+        }
+        ptr++;
+    }
+
+    uint32_t frequency, repeat, offset;
+    if (!readDecimal(ptr, frequency) || !readDecimal(ptr, repeat) || !readDecimal(ptr, offset))
+    {
+        return parse_invalid_header;
+    }
+    if (frequency < GC_MIN_CARRIER_HZ || frequency > GC_MAX_CARRIER_HZ)
+    {
+        return parse_invalid_duration;
+    }
+
+    raw.carrierHz = frequency;
+    raw.count = 0;
+    while (*ptr)
+    {
+        uint32_t periods;
+        if (!readDecimal(ptr, periods))
+        {
+            return parse_invalid_char;
+        }
+        if (periods == 0 || periods > 0xFFFF)
+        {
+            return parse_invalid_duration;
+        }
+        if (!appendDuration(raw, ((uint64_t)periods * 1000000 + frequency / 2) / frequency))
+        {
+            return parse_too_long;
+        }
+    }
+    if (raw.count == 0 || (raw.count & 1))
+    {
+        return parse_length_mismatch;
+    }
+    if ((offset & 1) == 0 || offset >= raw.count)
+    {
+        return parse_invalid_duration;
+    }
+    raw.repeatStart = offset - 1;
+    return parse_ok;
+}
+
+static bool formatGlobalCache(const ir_raw_code_t &raw, char *text, uint16_t maxLength)
+{
+    if (raw.carrierHz == 0)
+    {
+        return false;
+    }
+    // a code without repeat section repeats as a whole
+    const uint16_t offset = raw.repeatStart < raw.count ? raw.repeatStart + 1 : 1;
+
+    ir_text_writer_t w = textWriter(text, maxLength);
+    if (!writeString(w, GC_SENDIR_PREFIX "1:1,1,") || !writeDecimal(w, raw.carrierHz) ||
+        !writeString(w, ",1,") || !writeDecimal(w, offset))
+    {
+        return false;
+    }
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        uint64_t periods = ((uint64_t)raw.durations[i] * raw.carrierHz + 500000) / 1000000;
+        if (periods == 0)
+        {
+            periods = 1;
+        }
+        if (periods > 0xFFFF || !writeChar(w, ',') || !writeDecimal(w, (uint32_t)periods))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Value of a base64 character, standard and url safe alphabet; -1 for others
+static int8_t base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+    if (c == '+' || c == '-')
+    {
+        return 62;
+    }
+    if (c == '/' || c == '_')
+    {
+        return 63;
+    }
+    return -1;
+}
+
+typedef struct {
+    const char *ptr;
+    uint32_t bits;
+    uint8_t bitCount;
+    bool invalid;
+} ir_base64_reader_t;
+
+// Decodes the next byte straight from the text. Returns false at the end of
+// the data or on an invalid character.
+static bool readBase64(ir_base64_reader_t &r, uint8_t &byte)
+{
+    while (r.bitCount < 8)
+    {
+        const char c = *r.ptr;
+        if (c == 0 || c == '=')
+        {
+            return false;
+        }
+        r.ptr++;
+        if (isCodeDelimiter(c))
+        {
+            continue;
+        }
+        const int8_t value = base64Value(c);
+        if (value < 0)
+        {
+            r.invalid = true;
+            return false;
+        }
+        r.bits = (r.bits << 6) | value;
+        r.bitCount += 6;
+    }
+    r.bitCount -= 8;
+    byte = (r.bits >> r.bitCount) & 0xFF;
+    return true;
+}
+
+// Packet: 0x26 (IR), repeat count, data length (little endian), data. Every
+// duration is one byte of ticks, or 0 followed by two bytes (big endian).
+static ir_parse_error parseBroadlink(const char *code, ir_raw_code_t &raw)
+{
+    ir_base64_reader_t r = {code, 0, 0, false};
+    uint8_t header[BROADLINK_HEADER_BYTES];
+    for (uint8_t i = 0; i < BROADLINK_HEADER_BYTES; i++)
+    {
+        if (!readBase64(r, header[i]))
+        {
+            return r.invalid ? parse_invalid_char : parse_invalid_header;
+        }
+    }
+    if (header[0] != BROADLINK_IR_PACKET)
+    {
+        return parse_invalid_header;
+    }
+
+    const uint16_t length = header[2] | (header[3] << 8);
+    raw.carrierHz = IR_RAW_DEFAULT_CARRIER_HZ;
+    raw.count = 0;
+    uint16_t read = 0;
+    while (read < length)
+    {
+        uint8_t bytes[3];
+        if (!readBase64(r, bytes[0]) ||
+            (bytes[0] == 0 && (!readBase64(r, bytes[1]) || !readBase64(r, bytes[2]))))
+        {
+            return r.invalid ? parse_invalid_char : parse_length_mismatch;
+        }
+        read += bytes[0] == 0 ? 3 : 1;
+        const uint32_t ticks = bytes[0] != 0 ? bytes[0] : (bytes[1] << 8) | bytes[2];
+        if (ticks == 0)
+        {
+            return parse_invalid_duration;
+        }
+        if (!appendDuration(raw, (ticks * BROADLINK_TICK_NUM + BROADLINK_TICK_DEN / 2) / BROADLINK_TICK_DEN))
+        {
+            return parse_too_long;
+        }
+    }
+    return finishWithoutRepeatSection(raw);
+}
+
+static uint32_t broadlinkTicks(uint32_t durationUs)
+{
+    const uint32_t ticks = ((uint64_t)durationUs * BROADLINK_TICK_DEN + BROADLINK_TICK_NUM / 2) / BROADLINK_TICK_NUM;
+    return ticks > 0 ? ticks : 1;
+}
+
+typedef struct {
+    ir_text_writer_t text;
+    uint32_t bits;
+    uint8_t bitCount;
+    uint16_t chars;
+} ir_base64_writer_t;
+
+static bool writeBase64(ir_base64_writer_t &w, uint8_t byte)
+{
+    w.bits = (w.bits << 8) | byte;
+    w.bitCount += 8;
+    while (w.bitCount >= 6)
+    {
+        w.bitCount -= 6;
+        w.chars++;
+        if (!writeChar(w.text, kBase64Chars[(w.bits >> w.bitCount) & 0x3F]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool finishBase64(ir_base64_writer_t &w)
+{
+    if (w.bitCount > 0)
+    {
+        w.chars++;
+        if (!writeChar(w.text, kBase64Chars[(w.bits << (6 - w.bitCount)) & 0x3F]))
+        {
+            return false;
+        }
+    }
+    for (; w.chars % 4 != 0; w.chars++)
+    {
+        if (!writeChar(w.text, '='))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool formatBroadlink(const ir_raw_code_t &raw, char *text, uint16_t maxLength)
+{
+    uint32_t length = 0;
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        const uint32_t ticks = broadlinkTicks(raw.durations[i]);
+        if (ticks > 0xFFFF)
+        {
+            return false;
+        }
+        length += ticks < 0x100 ? 1 : 3;
+    }
+    if (length > 0xFFFF)
+    {
+        return false;
+    }
+
+    ir_base64_writer_t w = {textWriter(text, maxLength), 0, 0, 0};
+    const uint8_t header[BROADLINK_HEADER_BYTES] = {BROADLINK_IR_PACKET, 0, (uint8_t)length, (uint8_t)(length >> 8)};
+    for (uint8_t i = 0; i < BROADLINK_HEADER_BYTES; i++)
+    {
+        if (!writeBase64(w, header[i]))
+        {
+            return false;
+        }
+    }
+    for (uint16_t i = 0; i < raw.count; i++)
+    {
+        const uint32_t ticks = broadlinkTicks(raw.durations[i]);
+        if (ticks >= 0x100 && (!writeBase64(w, 0) || !writeBase64(w, ticks >> 8)))
+        {
+            return false;
+        }
+        if (!writeBase64(w, ticks & 0xFF))
+        {
+            return false;
+        }
+    }
+    return finishBase64(w);
+}
+
+static bool nextBase64Byte(void *context, uint8_t &byte)
+{
+    return readBase64(*(ir_base64_reader_t *)context, byte);
+}
+
+static ir_parse_error parseBinary(const char *code, ir_raw_code_t &raw)
+{
+    ir_base64_reader_t r = {code, 0, 0, false};
+    ir_byte_source_t source = {&r, nextBase64Byte};
+    const ir_parse_error err = decodeBinaryRaw(source, raw);
+    if (r.invalid)
+    {
+        return parse_invalid_char;
+    }
+    if (err == parse_ok && raw.count == 0)
+    {
+        return parse_empty;
+    }
+    return err;
+}
+
+static bool formatBinary(const ir_raw_code_t &raw, char *text, uint16_t maxLength)
+{
+    // the bytes are encoded into the text buffer and moved to its end; the
+    // base64 text written from the front never catches up with them
+    const uint16_t length = encodeBinaryRaw(raw, (uint8_t *)text, maxLength);
+    if (length == 0 || maxLength < 4 * ((length + 2) / 3) + 4)
+    {
+        return false;
+    }
+    const uint8_t *bytes = (const uint8_t *)text + maxLength - length;
+    memmove((uint8_t *)bytes, text, length);
+
+    ir_base64_writer_t w = {textWriter(text, maxLength), 0, 0, 0};
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (!writeBase64(w, bytes[i]))
+        {
+            return false;
+        }
+    }
+    return finishBase64(w);
+}
+
+static const ir_format_handler_t kIRFormats[] = {
+    {"pronto", parsePronto, formatPronto},
+    {"raw", parseRaw, formatRaw},
+    {"globalcache", parseGlobalCache, formatGlobalCache},
+    {"broadlink", parseBroadlink, formatBroadlink},
+    {"binary", parseBinary, formatBinary},
+};
+
+const ir_format_handler_t *findIRFormat(const char *name)
+{
+    if (name == NULL)
+    {
+        return NULL;
+    }
+    for (const ir_format_handler_t &handler : kIRFormats)
+    {
+        if (strcmp(name, handler.name) == 0)
+        {
+            return &handler;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,41 @@
+// Copyright 2024 Craig Petchell
+
+// Handlers of the timing based code formats. Every handler turns its format
+// into a raw code (see ir_timing.h), which is encoded and sent the same way
+// for all of them, and writes raw codes back in its format.
+//
+//   pronto       "0000 006D 0022 0002 0157 00AB ..."
+//   raw          "[carrier Hz;]9000,4500,560,..." durations in microseconds
+//   globalcache  "sendir,1:1,1,38000,1,1,343,171,..." iTach sendir command
+//   broadlink    "JgBQAAABKJIUEhQ2..." base64 packet of Broadlink remotes
+//   binary       "AY2pAgEiJAbWAqsBFRUV..." base64 compact binary code, see ir_binary.h
+//
+// Formats without repeat section (raw, broadlink) send the whole code for
+// every repeat. Repeat counts within the codes are ignored, repeats are
+// requested as for every other code.
+
+#ifndef IR_FORMATS_H_
+#define IR_FORMATS_H_
+
+#include <stdint.h>
+#include "ir_parse_error.h"
+#include "ir_timing.h"
+
+// Carrier of formats that do not specify one
+#define IR_RAW_DEFAULT_CARRIER_HZ 38000
+// Space added to codes that end with a mark, IRremoteESP8266's default message gap
+#define IR_RAW_TRAILING_GAP_US 100000
+
+typedef struct {
+    const char *name;
+    // Parses a code into `raw`, which brings the buffer for the durations.
+    ir_parse_error (*parse)(const char *code, ir_raw_code_t &raw);
+    // Writes `raw` as terminated code text. Returns false if it does not fit
+    // into maxLength characters or cannot be expressed in the format.
+    bool (*format)(const ir_raw_code_t &raw, char *text, uint16_t maxLength);
+} ir_format_handler_t;
+
+// Handler of the named timing format, NULL if there is none.
+const ir_format_handler_t *findIRFormat(const char *name);
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_hex.h"
+#include <string.h>
+
+const int8_t kHexDigitValue[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static inline void skipHexPrefix(const char *&hex, uint16_t &len)
+{
+    if (len > 1 && hex[0] == '0' && (hex[1] == 'x' || hex[1] == 'X'))
+    {
+        hex += 2;
+        len -= 2;
+    }
+}
+
+// Decodes exactly `len` (<= 16) digits. Returns false on a non hex character.
+static inline bool decodeDigits(const char *hex, uint16_t len, uint64_t &value)
+{
+    uint64_t result = 0;
+    int8_t invalid = 0;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        const int8_t nibble = kHexDigitValue[(uint8_t)hex[i]];
+        // collect the sign bit of all digits and check once at the end
+        invalid |= nibble;
+        result = (result << 4) | (uint8_t)nibble;
+    }
+    value = result;
+    return invalid >= 0;
+}
+
+ir_parse_error decodeHexValue(const char *hex, uint16_t len, uint64_t &value)
+{
+    skipHexPrefix(hex, len);
+    if (len == 0)
+    {
+        return parse_invalid_code;
+    }
+    if (len > 16)
+    {
+        return parse_code_overflow;
+    }
+    if (!decodeDigits(hex, len, value))
+    {
+        return parse_invalid_code;
+    }
+    return parse_ok;
+}
+
+ir_parse_error decodeHexState(const char *hex, uint16_t len, uint8_t *state, uint16_t stateSize)
+{
+    skipHexPrefix(hex, len);
+    if (len == 0)
+    {
+        return parse_invalid_code;
+    }
+    if (len > 2 * (uint32_t)stateSize)
+    {
+        return parse_code_overflow;
+    }
+
+    // Walk from the least significant end, decoding 16 digits (8 bytes) per step.
+    uint8_t *statePtr = state + stateSize;
+    const char *end = hex + len;
+    while (end > hex)
+    {
+        const uint16_t chunk = (end - hex) > 16 ? 16 : (uint16_t)(end - hex);
+        uint64_t word;
+        if (!decodeDigits(end - chunk, chunk, word))
+        {
+            return parse_invalid_code;
+        }
+        end -= chunk;
+
+        const uint16_t bytes = (chunk + 1) / 2;
+        for (uint16_t i = 0; i < bytes; i++)
+        {
+            *--statePtr = (uint8_t)word;
+            word >>= 8;
+        }
+    }
+
+    // zero the leading bytes not covered by the code
+    memset(state, 0, statePtr - state);
+    return parse_ok;
+}
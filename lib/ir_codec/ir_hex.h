@@ -0,0 +1,21 @@
+// Copyright 2024 Craig Petchell
+
+// Table driven decoding of hexadecimal strings into integers and AC state arrays.
+
+#ifndef IR_HEX_H_
+#define IR_HEX_H_
+
+#include <stdint.h>
+#include "ir_parse_error.h"
+
+// Value of every character as hex digit; -1 for characters that are no hex digit.
+extern const int8_t kHexDigitValue[256];
+
+// Decodes up to 16 hex digits (optionally prefixed with 0x) into `value`.
+ir_parse_error decodeHexValue(const char *hex, uint16_t len, uint64_t &value);
+
+// Decodes hex digits (optionally prefixed with 0x) into a big endian state array
+// of `stateSize` bytes. Digits are right aligned, missing leading bytes are zero.
+ir_parse_error decodeHexState(const char *hex, uint16_t len, uint8_t *state, uint16_t stateSize);
+
+#endif
@@ -0,0 +1,202 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_jitter.h"
+
+#include <string.h>
+
+static uint8_t bucketOf(uint32_t us)
+{
+    uint8_t bucket = 0;
+    while (us > 0 && bucket < IR_JITTER_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static inline uint32_t absTicks(int32_t ticks)
+{
+    return ticks < 0 ? -(uint32_t)ticks : ticks;
+}
+
+// Upper bound of the bucket that holds the 99th percentile, at most `maxUs`
+static uint32_t percentile99(const uint32_t *histogram, uint32_t maxUs)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < IR_JITTER_BUCKETS; i++)
+    {
+        total += histogram[i];
+    }
+    const uint32_t target = total - total / 100;
+    uint32_t count = 0;
+    for (uint8_t i = 0; i < IR_JITTER_BUCKETS - 1; i++)
+    {
+        count += histogram[i];
+        if (count >= target)
+        {
+            const uint32_t bound = (1UL << i) - 1;
+            return bound < maxUs ? bound : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+IrJitterStats::IrJitterStats(uint32_t ticksPerUs, uint32_t overrunUs)
+    : ticksPerUs(ticksPerUs > 0 ? ticksPerUs : 1), overrunUs(overrunUs), resetRequested(false)
+{
+    reset();
+}
+
+void IrJitterStats::reset()
+{
+    memset(&totals.beginUpdate(), 0, sizeof(ir_jitter_totals_t));
+    totals.endUpdate();
+    current = 0;
+    inFrame = false;
+    memset(encodedCodes, 0, sizeof(encodedCodes));
+    memset(encodedTicks, 0, sizeof(encodedTicks));
+    nextEncoded = 0;
+}
+
+void IrJitterStats::startFrame(uint32_t now)
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+    {
+        reset();
+    }
+    inFrame = true;
+    frameStart = now;
+    scheduled = 0;
+    lastDrift = 0;
+    frameDriftUs = 0;
+    frameOverrun = false;
+}
+
+void IrJitterStats::edge(uint32_t now, uint32_t intendedUs)
+{
+    if (!inFrame)
+    {
+        return;
+    }
+    scheduled += intendedUs * ticksPerUs;
+    // tick counters wrap, differences stay valid
+    const int32_t drift = (int32_t)((now - frameStart) - scheduled);
+    const uint32_t jitterUs = absTicks(drift - lastDrift) / ticksPerUs;
+    const uint32_t driftUs = absTicks(drift) / ticksPerUs;
+    lastDrift = drift;
+    if (driftUs > frameDriftUs)
+    {
+        frameDriftUs = driftUs;
+    }
+
+    ir_jitter_totals_t &update = totals.beginUpdate();
+    ir_jitter_window_t &window = update.windows[current];
+    window.edgeHistogram[bucketOf(jitterUs)]++;
+    if (jitterUs > window.edgeMaxUs)
+    {
+        window.edgeMaxUs = jitterUs;
+    }
+    if (jitterUs > overrunUs)
+    {
+        update.overruns++;
+        frameOverrun = true;
+    }
+    update.edges++;
+    totals.endUpdate();
+}
+
+// Counts a finished frame into an update of the totals.
+void IrJitterStats::addFrame(ir_jitter_totals_t &update, uint32_t driftUs, bool overrun)
+{
+    update.frames++;
+    if (overrun)
+    {
+        update.overrunFrames++;
+    }
+
+    ir_jitter_window_t &window = update.windows[current];
+    window.frameHistogram[bucketOf(driftUs)]++;
+    if (driftUs > window.frameMaxUs)
+    {
+        window.frameMaxUs = driftUs;
+    }
+    // the window rolls over: the older half is dropped
+    if (++window.frames >= IR_JITTER_WINDOW_FRAMES)
+    {
+        current ^= 1;
+        memset(&update.windows[current], 0, sizeof(ir_jitter_window_t));
+    }
+}
+
+void IrJitterStats::endFrame()
+{
+    if (!inFrame)
+    {
+        return;
+    }
+    inFrame = false;
+    addFrame(totals.beginUpdate(), frameDriftUs, frameOverrun);
+    totals.endUpdate();
+}
+
+void IrJitterStats::encodedFrame(uint32_t start, uint32_t end, uint32_t code)
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+    {
+        reset();
+    }
+    const uint32_t ticks = end - start;
+    uint8_t slot = 0;
+    while (slot < IR_JITTER_ENCODED_CODES && (encodedTicks[slot] == 0 || encodedCodes[slot] != code))
+    {
+        slot++;
+    }
+    if (slot == IR_JITTER_ENCODED_CODES)
+    {
+        // first frame of the code: it sets the pace
+        slot = nextEncoded;
+        nextEncoded = (nextEncoded + 1) % IR_JITTER_ENCODED_CODES;
+        encodedCodes[slot] = code;
+        encodedTicks[slot] = ticks;
+    }
+    else if (ticks < encodedTicks[slot])
+    {
+        encodedTicks[slot] = ticks;
+    }
+    const uint32_t driftUs = (ticks - encodedTicks[slot]) / ticksPerUs;
+
+    ir_jitter_totals_t &update = totals.beginUpdate();
+    addFrame(update, driftUs, driftUs > overrunUs);
+    if (driftUs > overrunUs)
+    {
+        update.overruns++;
+    }
+    update.encodedFrames++;
+    totals.endUpdate();
+}
+
+void IrJitterStats::report(ir_jitter_report_t &report) const
+{
+    ir_jitter_totals_t copy;
+    totals.read(copy);
+
+    report.frames = copy.frames;
+    report.edges = copy.edges;
+    report.overruns = copy.overruns;
+    report.overrunFrames = copy.overrunFrames;
+    report.encodedFrames = copy.encodedFrames;
+
+    const ir_jitter_window_t &a = copy.windows[0];
+    const ir_jitter_window_t &b = copy.windows[1];
+    report.windowFrames = a.frames + b.frames;
+    report.edgeMaxUs = a.edgeMaxUs > b.edgeMaxUs ? a.edgeMaxUs : b.edgeMaxUs;
+    report.frameMaxUs = a.frameMaxUs > b.frameMaxUs ? a.frameMaxUs : b.frameMaxUs;
+    for (uint8_t i = 0; i < IR_JITTER_BUCKETS; i++)
+    {
+        report.edgeHistogram[i] = a.edgeHistogram[i] + b.edgeHistogram[i];
+        report.frameHistogram[i] = a.frameHistogram[i] + b.frameHistogram[i];
+    }
+    report.edgeP99Us = percentile99(report.edgeHistogram, report.edgeMaxUs);
+    report.frameP99Us = percentile99(report.frameHistogram, report.frameMaxUs);
+}
@@ -0,0 +1,114 @@
+// Copyright 2024 Craig Petchell
+
+// Timing accuracy of emitted IR codes. The sender timestamps the end of every
+// mark and space it emits; each timestamp is compared with the schedule the
+// frame was meant to follow. Two histograms are kept over a rolling window of
+// recent frames: how much single marks and spaces were stretched (jitter),
+// and how far the edges of a frame drifted from its schedule at most.
+// Frames of protocol encoders report no edges; they are timed as a whole.
+// Histogram bucket i counts values of at least 2^(i-1) and below 2^i
+// microseconds, bucket 0 counts exact ones, the last one everything above.
+
+#ifndef IR_JITTER_H_
+#define IR_JITTER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "ir_seqlock.h"
+
+#define IR_JITTER_BUCKETS 16
+// The window holds between one and two times this number of frames
+#define IR_JITTER_WINDOW_FRAMES 64
+// Codes whose fastest encoded frame is remembered
+#define IR_JITTER_ENCODED_CODES 8
+
+typedef struct {
+    // since the last reset
+    uint32_t frames;
+    uint32_t edges;
+    uint32_t overruns;      // marks and spaces stretched by more than the overrun limit
+    uint32_t overrunFrames; // frames with at least one overrun
+    uint32_t encodedFrames; // frames of protocol encoders, timed as a whole
+    // over the window
+    uint32_t windowFrames;
+    uint32_t edgeMaxUs;     // largest stretch of a mark or space
+    uint32_t edgeP99Us;     // upper bound of the bucket holding the 99th percentile
+    uint32_t frameMaxUs;    // largest drift of a frame from its schedule
+    uint32_t frameP99Us;
+    uint32_t edgeHistogram[IR_JITTER_BUCKETS];
+    uint32_t frameHistogram[IR_JITTER_BUCKETS];
+} ir_jitter_report_t;
+
+class IrJitterStats
+{
+public:
+    // Timestamps are counted in `ticksPerUs` ticks per microsecond, e.g. CPU
+    // cycles. Marks and spaces stretched by more than `overrunUs` are overruns.
+    IrJitterStats(uint32_t ticksPerUs, uint32_t overrunUs);
+
+    // The first mark of a frame starts at `now`.
+    void startFrame(uint32_t now);
+
+    // A mark or space meant to last `intendedUs` ended at `now`.
+    void edge(uint32_t now, uint32_t intendedUs);
+
+    // The frame ended; its trailing gap is not measured.
+    void endFrame();
+
+    // A protocol encoder sent a frame of `code` from `start` to `end`. Frames
+    // of the same code are meant to take the same time: the frame drifted by
+    // how much longer it took than the fastest one of its code seen so far.
+    void encodedFrame(uint32_t start, uint32_t end, uint32_t code);
+
+    // May be called from other tasks while frames are measured: the
+    // statistics are copied until no update overlapped the copy.
+    void report(ir_jitter_report_t &report) const;
+
+    // Clears the statistics before the next frame.
+    void requestReset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    typedef struct {
+        uint32_t frames;
+        uint32_t edgeMaxUs;
+        uint32_t frameMaxUs;
+        uint32_t edgeHistogram[IR_JITTER_BUCKETS];
+        uint32_t frameHistogram[IR_JITTER_BUCKETS];
+    } ir_jitter_window_t;
+
+    // what report() copies
+    typedef struct {
+        uint32_t frames;
+        uint32_t edges;
+        uint32_t overruns;
+        uint32_t overrunFrames;
+        uint32_t encodedFrames;
+        // the current window and the one before
+        ir_jitter_window_t windows[2];
+    } ir_jitter_totals_t;
+
+    uint32_t ticksPerUs;
+    uint32_t overrunUs;
+    std::atomic<bool> resetRequested;
+
+    IrSeqlock<ir_jitter_totals_t> totals;
+    uint8_t current;
+
+    // fastest frame seen of the last codes sent by protocol encoders, in ticks
+    uint32_t encodedCodes[IR_JITTER_ENCODED_CODES];
+    uint32_t encodedTicks[IR_JITTER_ENCODED_CODES];
+    uint8_t nextEncoded;
+
+    // frame being measured, in ticks
+    bool inFrame;
+    uint32_t frameStart;
+    uint32_t scheduled;
+    int32_t lastDrift;
+    uint32_t frameDriftUs;
+    bool frameOverrun;
+
+    void reset();
+    void addFrame(ir_jitter_totals_t &update, uint32_t driftUs, bool overrun);
+};
+
+#endif
@@ -0,0 +1,47 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_parse_error.h"
+
+const char *irParseErrorToString(ir_parse_error error)
+{
+    switch (error)
+    {
+    case parse_ok:
+        return "OK";
+    case parse_empty:
+        return "IR code is empty";
+    case parse_invalid_char:
+        return "IR code contains invalid characters";
+    case parse_word_overflow:
+        return "Pronto word exceeds 16 bits";
+    case parse_too_long:
+        return "Length of IR code exceeds buffer";
+    case parse_header_too_short:
+        return "Pronto header incomplete";
+    case parse_unsupported_type:
+        return "Pronto code type not supported";
+    case parse_invalid_frequency:
+        return "Pronto frequency invalid";
+    case parse_length_mismatch:
+        return "Pronto burst pair count does not match code length";
+    case parse_missing_field:
+        return "IR code must have the format protocol;code;bits;repeats";
+    case parse_invalid_protocol:
+        return "Protocol field invalid or not supported";
+    case parse_invalid_code:
+        return "Code field is not hexadecimal";
+    case parse_code_overflow:
+        return "Code field exceeds number of bits";
+    case parse_invalid_bits:
+        return "Bits field invalid";
+    case parse_invalid_repeat:
+        return "Repeats field invalid";
+    case parse_unknown_format:
+        return "Unknown IR format";
+    case parse_invalid_header:
+        return "IR code header invalid";
+    case parse_invalid_duration:
+        return "IR code duration or frequency out of range";
+    }
+    return "Unknown error";
+}
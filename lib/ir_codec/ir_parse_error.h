@@ -0,0 +1,31 @@
+// Copyright 2024 Craig Petchell
+
+// Error codes reported while turning textual IR codes into IR messages.
+
+#ifndef IR_PARSE_ERROR_H_
+#define IR_PARSE_ERROR_H_
+
+enum ir_parse_error {
+    parse_ok = 0,
+    parse_empty,            // no code given
+    parse_invalid_char,     // character that is neither hex digit nor delimiter
+    parse_word_overflow,    // pronto word with more than 4 hex digits
+    parse_too_long,         // more words than fit into the message buffer
+    parse_header_too_short, // less than the 4 pronto header words
+    parse_unsupported_type, // pronto type other than learned (0000)
+    parse_invalid_frequency,// pronto frequency word is zero
+    parse_length_mismatch,  // burst pair counts do not match the number of words
+    parse_missing_field,    // UC code does not consist of protocol;code;bits;repeats
+    parse_invalid_protocol, // protocol field empty, unknown or not sendable as hex
+    parse_invalid_code,     // code field empty or not hexadecimal
+    parse_code_overflow,    // code has more digits than fit into bits / state
+    parse_invalid_bits,     // bits field not a number or out of range
+    parse_invalid_repeat,   // repeats field not a number or too large
+    parse_unknown_format,   // format is neither hex nor one of the timing formats
+    parse_invalid_header,   // sendir command or broadlink packet header malformed
+    parse_invalid_duration, // duration, carrier or repeat offset out of range
+};
+
+const char *irParseErrorToString(ir_parse_error error);
+
+#endif
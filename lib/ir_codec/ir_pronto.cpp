@@ -0,0 +1,84 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_pronto.h"
+#include "ir_hex.h"
+
+static inline bool isProntoDelimiter(char c)
+{
+    return c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n';
+}
+
+ir_parse_error parseProntoCode(const char *code, uint16_t *words, uint16_t maxWords, uint16_t &wordCount)
+{
+    wordCount = 0;
+    if (code == nullptr)
+    {
+        return parse_empty;
+    }
+
+    uint16_t count = 0;
+    uint16_t value = 0;
+    uint8_t digits = 0;
+
+    for (const char *ptr = code;; ptr++)
+    {
+        const char c = *ptr;
+        if (c == 0 || isProntoDelimiter(c))
+        {
+            if (digits > 0)
+            {
+                if (count >= maxWords)
+                {
+                    return parse_too_long;
+                }
+                words[count++] = value;
+                value = 0;
+                digits = 0;
+            }
+            if (c == 0)
+            {
+                break;
+            }
+            continue;
+        }
+
+        const int8_t nibble = kHexDigitValue[(uint8_t)c];
+        if (nibble < 0)
+        {
+            return parse_invalid_char;
+        }
+        if (++digits > 4)
+        {
+            return parse_word_overflow;
+        }
+        value = (value << 4) | nibble;
+    }
+
+    wordCount = count;
+
+    if (count == 0)
+    {
+        return parse_empty;
+    }
+    if (count < PRONTO_HEADER_WORDS)
+    {
+        return parse_header_too_short;
+    }
+    if (words[PRONTO_TYPE_OFFSET] != 0x0000)
+    {
+        // only learned, modulated codes are supported by IRsend::sendPronto
+        return parse_unsupported_type;
+    }
+    if (words[PRONTO_FREQ_OFFSET] == 0)
+    {
+        return parse_invalid_frequency;
+    }
+
+    const uint32_t burstPairs = (uint32_t)words[PRONTO_ONCE_OFFSET] + words[PRONTO_REPEAT_OFFSET];
+    if (burstPairs == 0 || PRONTO_HEADER_WORDS + 2 * burstPairs != count)
+    {
+        return parse_length_mismatch;
+    }
+
+    return parse_ok;
+}
@@ -0,0 +1,30 @@
+// Copyright 2024 Craig Petchell
+
+// Parser for Pronto hex codes (e.g. "0000 006D 0022 0002 0157 00AC ...").
+// Decodes straight from the source string without copying or tokenizing it.
+
+#ifndef IR_PRONTO_H_
+#define IR_PRONTO_H_
+
+#include <stdint.h>
+#include "ir_parse_error.h"
+
+// Layout of the pronto header words
+#define PRONTO_TYPE_OFFSET 0
+#define PRONTO_FREQ_OFFSET 1
+#define PRONTO_ONCE_OFFSET 2
+#define PRONTO_REPEAT_OFFSET 3
+#define PRONTO_HEADER_WORDS 4
+
+// Pronto frequency words count periods of a 4.145146 MHz clock
+#define PRONTO_CLOCK_HZ 4145146UL
+#define PRONTO_CLOCK_PERIOD_PS 241246ULL
+// the same period in microseconds, 16.16 fixed point
+#define PRONTO_CLOCK_PERIOD_Q16 15810UL
+
+// Parses a pronto code into `words`. Words may be separated by any mix of
+// spaces, commas, tabs and line breaks. On success `wordCount` holds the
+// number of decoded words and the header is validated against the length.
+ir_parse_error parseProntoCode(const char *code, uint16_t *words, uint16_t maxWords, uint16_t &wordCount);
+
+#endif
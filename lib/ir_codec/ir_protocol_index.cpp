@@ -0,0 +1,64 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_protocol_index.h"
+
+#include <string.h>
+#include <strings.h>
+
+#define FNV32_OFFSET_BASIS 0x811c9dc5UL
+#define FNV32_PRIME 0x01000193UL
+
+// FNV-1a over the name with letters folded to lower case
+static uint32_t nameHash(const char *name)
+{
+    uint32_t hash = FNV32_OFFSET_BASIS;
+    for (; *name; name++)
+    {
+        const char c = *name;
+        hash = (hash ^ (uint8_t)((c >= 'A' && c <= 'Z') ? (c | 0x20) : c)) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+IrProtocolIndex::IrProtocolIndex(const char *names) : names(names), count(0)
+{
+    memset(slots, 0, sizeof(slots));
+    const char *ptr = names;
+    while (*ptr && count < IR_MAX_PROTOCOLS)
+    {
+        offsets[count] = (uint16_t)(ptr - names);
+        uint16_t slot = nameHash(ptr) & (IR_PROTOCOL_INDEX_SLOTS - 1);
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (IR_PROTOCOL_INDEX_SLOTS - 1);
+        }
+        slots[slot] = ++count;
+        ptr += strlen(ptr) + 1;
+    }
+}
+
+int16_t IrProtocolIndex::find(const char *name) const
+{
+    uint16_t slot = nameHash(name) & (IR_PROTOCOL_INDEX_SLOTS - 1);
+    // the table is never full, so every probe sequence ends at an empty slot
+    while (slots[slot] != 0)
+    {
+        const uint16_t type = slots[slot] - 1;
+        if (strcasecmp(name, names + offsets[type]) == 0)
+        {
+            return type;
+        }
+        slot = (slot + 1) & (IR_PROTOCOL_INDEX_SLOTS - 1);
+    }
+    return -1;
+}
+
+const char *IrProtocolIndex::name(int16_t type) const
+{
+    return (type >= 0 && type < count) ? names + offsets[type] : NULL;
+}
+
+uint16_t IrProtocolIndex::size() const
+{
+    return count;
+}
@@ -0,0 +1,40 @@
+// Copyright 2024 Craig Petchell
+
+// Hash index over the protocol names of IRremoteESP8266, so resolving the
+// protocol of a hex code takes about one string comparison instead of one per
+// known protocol. The names come from the library itself (one terminated
+// name per protocol number, an empty name ends the list), so the index always
+// matches the protocols of the library it is built with.
+
+#ifndef IR_PROTOCOL_INDEX_H_
+#define IR_PROTOCOL_INDEX_H_
+
+#include <stdint.h>
+
+#define IR_MAX_PROTOCOLS 256
+// Twice the protocols, so probe sequences stay short
+#define IR_PROTOCOL_INDEX_SLOTS 512
+
+class IrProtocolIndex
+{
+public:
+    explicit IrProtocolIndex(const char *names);
+
+    // Protocol number of `name`, ignoring case. -1 if there is none.
+    int16_t find(const char *name) const;
+
+    // Name of protocol number `type`, NULL if there is none.
+    const char *name(int16_t type) const;
+
+    uint16_t size() const;
+
+private:
+    const char *names;
+    uint16_t count;
+    // offset of every name in `names`, by protocol number
+    uint16_t offsets[IR_MAX_PROTOCOLS];
+    // protocol number + 1 by hash, 0 = empty
+    uint16_t slots[IR_PROTOCOL_INDEX_SLOTS];
+};
+
+#endif
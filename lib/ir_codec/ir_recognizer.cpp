@@ -0,0 +1,289 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_recognizer.h"
+
+// Deviation from the nominal durations accepted for learned codes
+#define IR_RECOGNIZE_TOLERANCE_PERCENT 25
+// Carriers further off belong to another protocol
+#define IR_RECOGNIZE_CARRIER_PERCENT 10
+// Shortest space taken as the gap after a frame
+#define IR_RECOGNIZE_MIN_GAP_US 5000
+// Slots of the longest manchester frame (RC6 mode 0)
+#define IR_MAX_MANCHESTER_SLOTS 48
+
+#define RC5_UNIT_US 889
+#define RC6_UNIT_US 444
+#define RC6_HDR_MARK_US 2666
+#define RC6_HDR_SPACE_US 889
+
+// One section of a raw code: bursts alternating mark and space
+typedef struct {
+    const uint32_t *durations;
+    uint16_t count;
+} ir_section_t;
+
+// Protocols telling ones from zeros by the length of the mark or the space
+typedef struct {
+    const char *protocol;
+    uint32_t carrierHz;
+    uint16_t hdrMark;
+    uint16_t hdrSpace;
+    uint16_t oneMark;
+    uint16_t oneSpace;
+    uint16_t zeroMark;
+    uint16_t zeroSpace;
+    bool stopMark;        // a mark follows the last bit, else its space is the gap
+    uint16_t repeatSpace; // header space of the repeat frame, 0 = none
+    uint8_t bits[3];      // accepted lengths, 0 = unused
+} ir_pulse_protocol_t;
+
+static const ir_pulse_protocol_t kPulseProtocols[] = {
+    {"NEC", 38000, 9000, 4500, 560, 1690, 560, 560, true, 2250, {32, 0, 0}},
+    {"SAMSUNG", 38000, 4480, 4480, 560, 1680, 560, 560, true, 0, {32, 0, 0}},
+    {"SONY", 40000, 2400, 600, 1200, 600, 600, 600, false, 0, {12, 15, 20}},
+};
+
+static inline uint32_t burstUs(const ir_section_t &section, uint16_t i)
+{
+    return section.durations[i];
+}
+
+static bool near(uint32_t value, uint32_t nominal, uint32_t percent)
+{
+    const uint32_t diff = value > nominal ? value - nominal : nominal - value;
+    return (uint64_t)diff * 100 <= (uint64_t)nominal * percent;
+}
+
+static inline bool matches(uint32_t us, uint32_t nominalUs)
+{
+    return near(us, nominalUs, IR_RECOGNIZE_TOLERANCE_PERCENT);
+}
+
+static bool decodePulse(const ir_section_t &section, const ir_pulse_protocol_t &p, ir_native_code_t &native)
+{
+    const uint16_t count = section.count;
+    const uint16_t trailer = p.stopMark ? 2 : 0;
+    if (count < 4 + trailer)
+    {
+        return false;
+    }
+    const uint16_t bits = (count - 2 - trailer) / 2;
+    if (bits != p.bits[0] && bits != p.bits[1] && bits != p.bits[2])
+    {
+        return false;
+    }
+    if (!matches(burstUs(section, 0), p.hdrMark) || !matches(burstUs(section, 1), p.hdrSpace))
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (uint16_t b = 0; b < bits; b++)
+    {
+        const uint32_t mark = burstUs(section, 2 + 2 * b);
+        const uint32_t space = burstUs(section, 3 + 2 * b);
+        // without stop mark the space of the last bit merges with the gap
+        const bool gap = !p.stopMark && b + 1 == bits;
+        if (gap && space < IR_RECOGNIZE_MIN_GAP_US)
+        {
+            return false;
+        }
+        if (matches(mark, p.oneMark) && (gap || matches(space, p.oneSpace)))
+        {
+            value = (value << 1) | 1;
+        }
+        else if (matches(mark, p.zeroMark) && (gap || matches(space, p.zeroSpace)))
+        {
+            value <<= 1;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (p.stopMark && (!matches(burstUs(section, count - 2), p.zeroMark) ||
+                       burstUs(section, count - 1) < IR_RECOGNIZE_MIN_GAP_US))
+    {
+        return false;
+    }
+
+    native.protocol = p.protocol;
+    native.value = value;
+    native.bits = bits;
+    return true;
+}
+
+// The short frame some protocols send while a key is held
+static bool isRepeatFrame(const ir_section_t &section, const char *protocol)
+{
+    for (const ir_pulse_protocol_t &p : kPulseProtocols)
+    {
+        if (p.protocol == protocol && p.repeatSpace != 0)
+        {
+            return section.count == 4 && matches(burstUs(section, 0), p.hdrMark) &&
+                   matches(burstUs(section, 1), p.repeatSpace) && matches(burstUs(section, 2), p.zeroMark) &&
+                   burstUs(section, 3) >= IR_RECOGNIZE_MIN_GAP_US;
+        }
+    }
+    return false;
+}
+
+// Splits the bursts from `start` on into half bit slots of `unitUs`, true
+// for mark. The gap after the last burst only fills up the last bit.
+static bool manchesterSlots(const ir_section_t &section, uint16_t start, uint32_t unitUs, bool leadingSpace,
+                            bool *slots, uint8_t &slotCount)
+{
+    slotCount = 0;
+    if (leadingSpace)
+    {
+        slots[slotCount++] = false;
+    }
+    for (uint16_t i = start; i + 1 < section.count; i++)
+    {
+        const uint32_t us = burstUs(section, i);
+        const uint32_t units = (us + unitUs / 2) / unitUs;
+        if (units == 0 || units > 3 || !matches(us, units * unitUs) || slotCount + units > IR_MAX_MANCHESTER_SLOTS)
+        {
+            return false;
+        }
+        for (uint32_t u = 0; u < units; u++)
+        {
+            slots[slotCount++] = (i & 1) == 0;
+        }
+    }
+    if (section.count == 0 || burstUs(section, section.count - 1) < IR_RECOGNIZE_MIN_GAP_US)
+    {
+        return false;
+    }
+    if (slotCount & 1)
+    {
+        slots[slotCount++] = false;
+    }
+    return true;
+}
+
+// Bit of a slot pair: 1 if it goes from `oneFirst` to the other level, -1 if the level does not change
+static int8_t manchesterBit(const bool *pair, bool oneFirst)
+{
+    if (pair[0] == pair[1])
+    {
+        return -1;
+    }
+    return pair[0] == oneFirst ? 1 : 0;
+}
+
+// RC5: 14 bits of 2 x 889us, a one goes from space to mark. Start bit, field
+// bit (inverted 7th command bit in RC5X), toggle, address and command.
+static bool decodeRC5(const ir_section_t &section, ir_native_code_t &native)
+{
+    bool slots[IR_MAX_MANCHESTER_SLOTS];
+    uint8_t slotCount;
+    // the first start bit begins with a space that is not part of the code
+    if (!manchesterSlots(section, 0, RC5_UNIT_US, true, slots, slotCount) || slotCount != 28)
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (uint8_t b = 0; b < 14; b++)
+    {
+        const int8_t bit = manchesterBit(slots + 2 * b, false);
+        if (bit < 0)
+        {
+            return false;
+        }
+        value = (value << 1) | bit;
+    }
+    if ((value >> 13) == 0)
+    {
+        return false;
+    }
+
+    const bool field = (value >> 12) & 1;
+    native.protocol = field ? "RC5" : "RC5X";
+    native.value = (value & 0xFFF) | (field ? 0 : 0x1000);
+    native.bits = field ? 12 : 13;
+    return true;
+}
+
+// RC6 mode 0: header, start bit, 3 mode bits, the double length trailer
+// (toggle) bit and 16 data bits, 2 x 444us each, a one goes from mark to space.
+static bool decodeRC6(const ir_section_t &section, ir_native_code_t &native)
+{
+    if (section.count < 2 || !matches(burstUs(section, 0), RC6_HDR_MARK_US) ||
+        !matches(burstUs(section, 1), RC6_HDR_SPACE_US))
+    {
+        return false;
+    }
+    bool slots[IR_MAX_MANCHESTER_SLOTS];
+    uint8_t slotCount;
+    if (!manchesterSlots(section, 2, RC6_UNIT_US, false, slots, slotCount) || slotCount != 44)
+    {
+        return false;
+    }
+    if (manchesterBit(slots, true) != 1 || slots[8] != slots[9] || slots[10] != slots[11])
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (uint8_t b = 1; b < 21; b++)
+    {
+        // the trailer bit spans slots 8 to 11
+        const uint8_t slot = b < 4 ? 2 * b : (b == 4 ? 8 : 2 * b + 2);
+        const bool pair[2] = {slots[slot], slots[b == 4 ? slot + 2 : slot + 1]};
+        const int8_t bit = manchesterBit(pair, true);
+        if (bit < 0)
+        {
+            return false;
+        }
+        value = (value << 1) | bit;
+    }
+    // mode 0 only
+    if ((value >> 17) != 0)
+    {
+        return false;
+    }
+
+    native.protocol = "RC6";
+    native.value = value;
+    native.bits = 20;
+    return true;
+}
+
+static bool decodeFrame(const ir_section_t &section, uint32_t carrierHz, ir_native_code_t &native)
+{
+    for (const ir_pulse_protocol_t &p : kPulseProtocols)
+    {
+        if (near(carrierHz, p.carrierHz, IR_RECOGNIZE_CARRIER_PERCENT) && decodePulse(section, p, native))
+        {
+            return true;
+        }
+    }
+    if (!near(carrierHz, 36000, IR_RECOGNIZE_CARRIER_PERCENT))
+    {
+        return false;
+    }
+    return decodeRC5(section, native) || decodeRC6(section, native);
+}
+
+bool recognizeIRCode(const ir_raw_code_t &raw, ir_native_code_t &native)
+{
+    const uint32_t carrierHz = raw.carrierHz;
+    const ir_section_t once = {raw.durations, raw.repeatStart};
+    const ir_section_t repeat = {raw.durations + raw.repeatStart, (uint16_t)(raw.count - raw.repeatStart)};
+
+    // codes without once section start with their repeat section
+    if (!decodeFrame(once.count > 0 ? once : repeat, carrierHz, native))
+    {
+        return false;
+    }
+    if (once.count == 0 || repeat.count == 0 || isRepeatFrame(repeat, native.protocol))
+    {
+        return true;
+    }
+    // the repeat section has to send the same frame again
+    ir_native_code_t again;
+    return decodeFrame(repeat, carrierHz, again) && again.protocol == native.protocol &&
+           again.value == native.value && again.bits == native.bits;
+}
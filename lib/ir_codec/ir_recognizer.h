@@ -0,0 +1,24 @@
+// Copyright 2024 Craig Petchell
+
+// Recognition of timing based codes that are plain frames of a common
+// protocol, so they can be sent as protocol value instead of as timings. Only
+// codes that match the protocol completely (carrier, every burst, repeat
+// section) are recognized; everything else keeps being sent as it is.
+
+#ifndef IR_RECOGNIZER_H_
+#define IR_RECOGNIZER_H_
+
+#include <stdint.h>
+#include "ir_timing.h"
+
+typedef struct {
+    const char *protocol; // protocol name as used in UC codes, e.g. "NEC"
+    uint64_t value;       // bits in the order they are sent, first bit is the MSB
+    uint16_t bits;
+} ir_native_code_t;
+
+// Recognizes a raw code of any timing format. Supported are NEC, Samsung,
+// Sony (12, 15 and 20 bits), RC5, RC5X and RC6 mode 0.
+bool recognizeIRCode(const ir_raw_code_t &raw, ir_native_code_t &native);
+
+#endif
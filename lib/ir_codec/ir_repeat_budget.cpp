@@ -0,0 +1,92 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_repeat_budget.h"
+
+static const uint32_t kClosed = 0xFFFF;
+
+static inline uint16_t ticketOf(uint32_t state)
+{
+    return state >> 16;
+}
+
+static inline uint16_t repeatsOf(uint32_t state)
+{
+    return state & 0xFFFF;
+}
+
+static inline uint32_t makeState(uint16_t ticket, uint32_t repeats)
+{
+    return ((uint32_t)ticket << 16) | (repeats > IR_MAX_REPEAT_BUDGET ? IR_MAX_REPEAT_BUDGET : repeats);
+}
+
+IrRepeatBudget::IrRepeatBudget() : state(kClosed)
+{
+}
+
+uint16_t IrRepeatBudget::open(uint16_t repeats)
+{
+    const uint16_t ticket = ticketOf(state.load(std::memory_order_relaxed)) + 1;
+    state.store(makeState(ticket, repeats), std::memory_order_release);
+    return ticket;
+}
+
+bool IrRepeatBudget::add(uint16_t ticket, uint16_t repeats)
+{
+    uint32_t current = state.load(std::memory_order_relaxed);
+    do
+    {
+        if (ticketOf(current) != ticket || repeatsOf(current) == kClosed)
+        {
+            return false;
+        }
+    } while (!state.compare_exchange_weak(current, makeState(ticket, repeatsOf(current) + (uint32_t)repeats),
+                                          std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+}
+
+bool IrRepeatBudget::take()
+{
+    uint32_t current = state.load(std::memory_order_relaxed);
+    uint32_t next;
+    do
+    {
+        if (repeatsOf(current) == kClosed)
+        {
+            return false;
+        }
+        // empty: close right away, an add() racing with the last frame must fail
+        next = repeatsOf(current) == 0 ? ((uint32_t)ticketOf(current) << 16) | kClosed : current - 1;
+    } while (!state.compare_exchange_weak(current, next,
+                                          std::memory_order_acq_rel, std::memory_order_relaxed));
+    return repeatsOf(current) != 0;
+}
+
+uint16_t IrRepeatBudget::takeAll()
+{
+    uint32_t current = state.load(std::memory_order_relaxed);
+    do
+    {
+        if (repeatsOf(current) == 0 || repeatsOf(current) == kClosed)
+        {
+            return 0;
+        }
+    } while (!state.compare_exchange_weak(current, makeState(ticketOf(current), 0),
+                                          std::memory_order_acq_rel, std::memory_order_relaxed));
+    return repeatsOf(current);
+}
+
+uint16_t IrRepeatBudget::close()
+{
+    uint32_t current = state.load(std::memory_order_relaxed);
+    while (!state.compare_exchange_weak(current, ((uint32_t)ticketOf(current) << 16) | kClosed,
+                                        std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+    }
+    return repeatsOf(current) == kClosed ? 0 : repeatsOf(current);
+}
+
+uint16_t IrRepeatBudget::remaining() const
+{
+    const uint16_t repeats = repeatsOf(state.load(std::memory_order_relaxed));
+    return repeats == kClosed ? 0 : repeats;
+}
@@ -0,0 +1,49 @@
+// Copyright 2024 Craig Petchell
+
+// Repeat frames owed to one send. Requests add repeats while the send is
+// pending or running, the IR task takes them one frame at a time. A take
+// that finds the budget empty closes it in the same step, as does the IR
+// task once the send is over. Further additions are refused, so every
+// repeat is either sent or reported back to its requester, never lost.
+// Lock-free; adding and taking may run concurrently on different tasks.
+
+#ifndef IR_REPEAT_BUDGET_H_
+#define IR_REPEAT_BUDGET_H_
+
+#include <stdint.h>
+#include <atomic>
+
+// Upper limit of the repeats a budget holds
+#define IR_MAX_REPEAT_BUDGET 0xFFFE
+
+class IrRepeatBudget
+{
+public:
+    IrRepeatBudget();
+
+    // Starts a new budget of `repeats` for a send. Returns the ticket
+    // needed to add to it later.
+    uint16_t open(uint16_t repeats);
+
+    // Adds repeats to the budget of `ticket`. Returns false if that budget
+    // is closed already or was reopened for another send.
+    bool add(uint16_t ticket, uint16_t repeats);
+
+    // Takes one repeat. Returns false if none is left; the budget is
+    // closed then.
+    bool take();
+
+    // Takes all repeats left.
+    uint16_t takeAll();
+
+    // Ends the budget. Returns the repeats that were not taken.
+    uint16_t close();
+
+    uint16_t remaining() const;
+
+private:
+    // ticket << 16 | repeats; repeats == kClosed after close()
+    std::atomic<uint32_t> state;
+};
+
+#endif
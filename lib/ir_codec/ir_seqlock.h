@@ -0,0 +1,53 @@
+// Copyright 2024 Craig Petchell
+
+// Statistics one task updates while other tasks read them. The sequence is
+// odd while an update is in progress; a reader copies the value until no
+// update overlapped its copy, so it never sees a value torn by an update.
+
+#ifndef IR_SEQLOCK_H_
+#define IR_SEQLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+template <typename T>
+class IrSeqlock
+{
+public:
+    IrSeqlock() : sequence(0)
+    {
+        memset(&value, 0, sizeof(value));
+    }
+
+    // Only one task may update the value, between beginUpdate() and endUpdate().
+    T &beginUpdate()
+    {
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return value;
+    }
+
+    void endUpdate()
+    {
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    // May be called from any task.
+    void read(T &copy) const
+    {
+        uint32_t before;
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&copy, (const void *)&value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((before & 1) != 0 || sequence.load(std::memory_order_relaxed) != before);
+    }
+
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+};
+
+#endif
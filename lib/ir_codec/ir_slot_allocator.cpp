@@ -0,0 +1,38 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_slot_allocator.h"
+
+IrSlotAllocator::IrSlotAllocator(uint8_t slots)
+    : slotCount(slots > 32 ? 32 : slots),
+      freeMask(slotCount == 32 ? 0xFFFFFFFFu : ((1u << slotCount) - 1))
+{
+}
+
+uint8_t IrSlotAllocator::acquire()
+{
+    uint32_t mask = freeMask.load(std::memory_order_relaxed);
+    while (mask != 0)
+    {
+        const uint8_t slot = __builtin_ctz(mask);
+        // on failure `mask` is reloaded and we retry with the next free slot
+        if (freeMask.compare_exchange_weak(mask, mask & ~(1u << slot),
+                                           std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return slot;
+        }
+    }
+    return IR_NO_SLOT;
+}
+
+void IrSlotAllocator::release(uint8_t slot)
+{
+    if (slot < slotCount)
+    {
+        freeMask.fetch_or(1u << slot, std::memory_order_release);
+    }
+}
+
+uint8_t IrSlotAllocator::available() const
+{
+    return __builtin_popcount(freeMask.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,35 @@
+// Copyright 2024 Craig Petchell
+
+// Lock-free allocator handing out indices of a fixed pool of up to 32 slots.
+// Safe to use concurrently from several tasks without a mutex.
+
+#ifndef IR_SLOT_ALLOCATOR_H_
+#define IR_SLOT_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#define IR_NO_SLOT 0xFF
+
+class IrSlotAllocator
+{
+public:
+    explicit IrSlotAllocator(uint8_t slots);
+
+    // Returns the index of a free slot or IR_NO_SLOT if all slots are in use.
+    uint8_t acquire();
+
+    // Returns a slot obtained by acquire() to the pool.
+    void release(uint8_t slot);
+
+    uint8_t available() const;
+
+    uint8_t size() const { return slotCount; }
+
+private:
+    const uint8_t slotCount;
+    // bit n set = slot n free
+    std::atomic<uint32_t> freeMask;
+};
+
+#endif
@@ -0,0 +1,106 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_timeline.h"
+#include "ir_pronto.h"
+
+#define IR_MAX_MERGED_TIMELINES 8
+
+uint32_t prontoCarrierHz(const uint16_t *words)
+{
+    const uint64_t periodPs = words[PRONTO_FREQ_OFFSET] * PRONTO_CLOCK_PERIOD_PS;
+    return periodPs == 0 ? 0 : (uint32_t)((1000000000000ULL + periodPs / 2) / periodPs);
+}
+
+uint32_t prontoPeriodQ16(const uint16_t *words)
+{
+    return words[PRONTO_FREQ_OFFSET] * PRONTO_CLOCK_PERIOD_Q16;
+}
+
+bool carriersCompatible(uint32_t hzA, uint32_t hzB)
+{
+    const uint32_t diff = hzA > hzB ? hzA - hzB : hzB - hzA;
+    return (uint64_t)diff * 100 <= (uint64_t)IR_CARRIER_TOLERANCE_PERCENT * (hzA < hzB ? hzA : hzB);
+}
+
+bool mergeTimelines(const ir_timeline_t *lines, uint8_t lineCount, uint32_t minSegmentUs,
+                    ir_segment_t *segments, uint16_t maxSegments, uint16_t &segmentCount)
+{
+    segmentCount = 0;
+    if (lineCount > IR_MAX_MERGED_TIMELINES)
+    {
+        return false;
+    }
+
+    uint16_t index[IR_MAX_MERGED_TIMELINES];
+    uint32_t remaining[IR_MAX_MERGED_TIMELINES];
+    for (uint8_t l = 0; l < lineCount; l++)
+    {
+        index[l] = 0;
+        remaining[l] = lines[l].count > 0 ? lines[l].timings[0] : 0;
+    }
+
+    for (;;)
+    {
+        // outputs in mark and time until the next edge of any timeline
+        bool active = false;
+        uint8_t channels = 0;
+        uint32_t step = UINT32_MAX;
+        for (uint8_t l = 0; l < lineCount; l++)
+        {
+            if (index[l] >= lines[l].count)
+            {
+                continue;
+            }
+            active = true;
+            if ((index[l] & 1) == 0)
+            {
+                channels |= lines[l].channels;
+            }
+            if (remaining[l] < step)
+            {
+                step = remaining[l];
+            }
+        }
+        if (!active)
+        {
+            break;
+        }
+
+        if (step > 0)
+        {
+            if (segmentCount > 0 && segments[segmentCount - 1].channels == channels)
+            {
+                segments[segmentCount - 1].durationUs += step;
+            }
+            else
+            {
+                // the previous segment is complete now
+                if (segmentCount > 0 && segments[segmentCount - 1].durationUs < minSegmentUs)
+                {
+                    return false;
+                }
+                if (segmentCount >= maxSegments)
+                {
+                    return false;
+                }
+                segments[segmentCount].durationUs = step;
+                segments[segmentCount].channels = channels;
+                segmentCount++;
+            }
+        }
+
+        for (uint8_t l = 0; l < lineCount; l++)
+        {
+            if (index[l] >= lines[l].count)
+            {
+                continue;
+            }
+            remaining[l] -= step;
+            while (remaining[l] == 0 && ++index[l] < lines[l].count)
+            {
+                remaining[l] = lines[l].timings[index[l]];
+            }
+        }
+    }
+    return true;
+}
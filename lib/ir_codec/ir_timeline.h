@@ -0,0 +1,49 @@
+// Copyright 2024 Craig Petchell
+
+// Edge timelines of timing based codes and merging of several timelines into
+// one schedule, so different codes can be sent on different outputs at once.
+// A timeline alternates mark and space durations in microseconds, starting
+// with a mark.
+
+#ifndef IR_TIMELINE_H_
+#define IR_TIMELINE_H_
+
+#include <stdint.h>
+
+// Carriers closer than this are sent with one common carrier
+#define IR_CARRIER_TOLERANCE_PERCENT 2
+
+typedef struct {
+    const uint32_t *timings;
+    uint16_t count;
+    uint8_t channels; // outputs driven by this timeline
+} ir_timeline_t;
+
+// Part of a merged schedule: the outputs in mark for durationUs, 0 = all in space
+typedef struct {
+    uint32_t durationUs;
+    uint8_t channels;
+} ir_segment_t;
+
+// Carrier frequency of a parsed pronto code.
+uint32_t prontoCarrierHz(const uint16_t *words);
+
+// Carrier period of a parsed pronto code in microseconds, 16.16 fixed point.
+uint32_t prontoPeriodQ16(const uint16_t *words);
+
+// Duration of a pronto burst of `periods` carrier periods. Cheap enough to
+// be called between two edges while sending.
+static inline uint32_t prontoBurstUs(uint16_t periods, uint32_t periodQ16)
+{
+    return (uint32_t)(((uint64_t)periods * periodQ16 + 0x8000) >> 16);
+}
+
+bool carriersCompatible(uint32_t hzA, uint32_t hzB);
+
+// Merges the timelines into one schedule. Fails if the schedule does not fit
+// into maxSegments or if edges of different timelines are closer than
+// minSegmentUs, which the transmitter could not reproduce.
+bool mergeTimelines(const ir_timeline_t *lines, uint8_t lineCount, uint32_t minSegmentUs,
+                    ir_segment_t *segments, uint16_t maxSegments, uint16_t &segmentCount);
+
+#endif
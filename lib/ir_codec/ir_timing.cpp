@@ -0,0 +1,237 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_timing.h"
+
+#include <string.h>
+
+// Timings saved before a repeated burst is worth a loop of its own; a loop
+// costs three timings and may split a literal run into two loops.
+#define IR_MIN_LOOP_SAVING 6
+
+// Appends one duration, splitting it if needed. Returns false if it does not fit.
+static bool appendTiming(uint32_t durationUs, uint16_t *timings, uint16_t maxTimings, uint16_t &length)
+{
+    while (durationUs > IR_TIMING_MAX_US)
+    {
+        if (length + 2 > maxTimings)
+        {
+            return false;
+        }
+        timings[length++] = IR_TIMING_MAX_US;
+        timings[length++] = 0;
+        durationUs -= IR_TIMING_MAX_US;
+    }
+    if (length >= maxTimings)
+    {
+        return false;
+    }
+    timings[length++] = durationUs;
+    return true;
+}
+
+static bool appendDurations(const uint32_t *durations, uint16_t count,
+                            uint16_t *timings, uint16_t maxTimings, uint16_t &length)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (!appendTiming(durations[i], timings, maxTimings, length))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Equal within the jitter of learned codes: 3% plus 8us
+static inline bool sameTiming(uint16_t a, uint16_t b)
+{
+    const uint16_t diff = a > b ? a - b : b - a;
+    return diff <= (a >> 5) + 8;
+}
+
+static bool sameRun(const uint16_t *a, const uint16_t *b, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (!sameTiming(a[i], b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void addLoop(ir_timing_layout_t &layout, uint16_t start, uint16_t length, uint16_t count)
+{
+    ir_timing_loop_t &loop = layout.loops[layout.loopCount++];
+    loop.start = start;
+    loop.length = length;
+    loop.count = count;
+}
+
+// Compresses the raw timings [start, end) in place into loops. Back to back
+// copies of a burst sequence are stored once; everything else goes into
+// literal loops played once. `reserve` loops are kept free for later sections.
+// Returns the end of the stored timings.
+static uint16_t compressSection(uint16_t *timings, uint16_t start, uint16_t end, ir_timing_layout_t &layout, uint8_t reserve)
+{
+    uint16_t out = start;
+    uint16_t literal = start;
+    uint16_t i = start;
+    while (i < end)
+    {
+        // the repeated run saving the most timings
+        uint16_t bestLength = 0;
+        uint16_t bestCount = 1;
+        uint32_t bestSaving = 0;
+        const uint8_t needed = (out > literal ? 1 : 0) + 2 + reserve;
+        if (layout.loopCount + needed <= IR_MAX_TIMING_LOOPS)
+        {
+            for (uint16_t p = 2; i + 2 * p <= end; p += 2)
+            {
+                if (!sameTiming(timings[i], timings[i + p]) || !sameTiming(timings[i + 1], timings[i + p + 1]))
+                {
+                    continue;
+                }
+                uint16_t count = 1;
+                while (i + (count + 1) * p <= end && sameRun(timings + i, timings + i + count * p, p))
+                {
+                    count++;
+                }
+                const uint32_t saving = (uint32_t)(count - 1) * p;
+                if (saving > bestSaving)
+                {
+                    bestSaving = saving;
+                    bestLength = p;
+                    bestCount = count;
+                }
+            }
+        }
+
+        if (bestSaving < IR_MIN_LOOP_SAVING)
+        {
+            // part of a literal run; writing never overtakes reading
+            timings[out++] = timings[i++];
+            timings[out++] = timings[i++];
+            continue;
+        }
+
+        if (out > literal)
+        {
+            addLoop(layout, literal, out - literal, 1);
+        }
+        memmove(timings + out, timings + i, bestLength * sizeof(uint16_t));
+        addLoop(layout, out, bestLength, bestCount);
+        out += bestLength;
+        literal = out;
+        i += bestLength * bestCount;
+    }
+    if (out > literal)
+    {
+        addLoop(layout, literal, out - literal, 1);
+    }
+    return out;
+}
+
+ir_parse_error encodeTimings(const ir_raw_code_t &raw, uint16_t *timings, uint16_t maxTimings, ir_timing_layout_t &layout)
+{
+    const uint16_t repeatCount = raw.count - raw.repeatStart;
+
+    layout.carrierHz = raw.carrierHz;
+    layout.length = 0;
+    layout.loopCount = 0;
+    if (!appendDurations(raw.durations, raw.repeatStart, timings, maxTimings, layout.length))
+    {
+        return parse_too_long;
+    }
+    layout.length = compressSection(timings, 0, layout.length, layout, repeatCount > 0 ? 1 : 0);
+
+    layout.repeatLoop = layout.loopCount;
+    const uint16_t repeatStart = layout.length;
+    if (!appendDurations(raw.durations + raw.repeatStart, repeatCount, timings, maxTimings, layout.length))
+    {
+        return parse_too_long;
+    }
+    layout.length = compressSection(timings, repeatStart, layout.length, layout, 0);
+    return parse_ok;
+}
+
+// Appends the timings of [start, end), joining split durations.
+static bool expandRun(const uint16_t *timings, uint16_t start, uint16_t end,
+                      uint32_t *out, uint16_t maxOut, uint16_t &count)
+{
+    for (uint16_t i = start; i < end; i++)
+    {
+        if (timings[i] == 0)
+        {
+            continue;
+        }
+        // odd positions are spaces, in the source as in the timeline
+        const uint16_t kind = i & 1;
+        if (count > 0 && ((count - 1) & 1) == kind)
+        {
+            out[count - 1] += timings[i];
+            continue;
+        }
+        if ((count & 1) != kind)
+        {
+            // a run starting with an empty mark
+            if (count >= maxOut)
+            {
+                return false;
+            }
+            out[count++] = 0;
+        }
+        if (count >= maxOut)
+        {
+            return false;
+        }
+        out[count++] = timings[i];
+    }
+    return true;
+}
+
+static bool expandLoops(const uint16_t *timings, const ir_timing_layout_t &layout, uint8_t first, uint8_t last,
+                        uint32_t *out, uint16_t maxOut, uint16_t &count)
+{
+    for (uint8_t l = first; l < last; l++)
+    {
+        const ir_timing_loop_t &loop = layout.loops[l];
+        for (uint16_t c = 0; c < loop.count; c++)
+        {
+            if (!expandRun(timings, loop.start, loop.start + loop.length, out, maxOut, count))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+uint16_t expandTimings(const uint16_t *timings, const ir_timing_layout_t &layout, uint16_t repeat,
+                       uint32_t *out, uint16_t maxOut)
+{
+    uint16_t count = 0;
+    if (layout.repeatLoop > 0)
+    {
+        if (!expandLoops(timings, layout, 0, layout.repeatLoop, out, maxOut, count))
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        repeat++;
+    }
+    if (layout.repeatLoop < layout.loopCount)
+    {
+        for (uint16_t r = 0; r < repeat; r++)
+        {
+            if (!expandLoops(timings, layout, layout.repeatLoop, layout.loopCount, out, maxOut, count))
+            {
+                return 0;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,57 @@
+// Copyright 2024 Craig Petchell
+
+// Ready to emit form of timing based codes: mark and space durations in
+// microseconds, alternating and starting with a mark. Codes of every timing
+// format are encoded into this form when a request is handled, so the IR task
+// only replays them.
+// Durations above IR_TIMING_MAX_US are split into IR_TIMING_MAX_US, 0, rest,
+// which keeps the alternation of marks and spaces.
+//
+// Bursts that repeat back to back (the same frame sent several times, runs of
+// equal bits) are stored once and described by loops: the code is played as
+// loop after loop, each playing `length` stored timings `count` times.
+
+#ifndef IR_TIMING_H_
+#define IR_TIMING_H_
+
+#include <stdint.h>
+#include "ir_parse_error.h"
+
+#define IR_TIMING_MAX_US 0xFFFF
+
+#define IR_MAX_TIMING_LOOPS 16
+
+typedef struct {
+    uint16_t start;  // first stored timing, always a mark
+    uint16_t length; // stored timings, whole mark/space pairs
+    uint16_t count;  // times the timings are played
+} ir_timing_loop_t;
+
+typedef struct {
+    uint32_t carrierHz;
+    uint16_t length;    // number of stored timings
+    uint8_t loopCount;
+    uint8_t repeatLoop; // first loop of the repeat section, == loopCount if there is none
+    ir_timing_loop_t loops[IR_MAX_TIMING_LOOPS];
+} ir_timing_layout_t;
+
+// A timing based code as the format handlers deliver it, before encoding
+typedef struct {
+    uint32_t carrierHz;
+    uint32_t *durations;  // microseconds, alternating mark and space, starting with a mark
+    uint16_t count;       // always even
+    uint16_t repeatStart; // first duration of the repeat section, == count without one
+    uint16_t maxCount;    // room in durations
+} ir_raw_code_t;
+
+// Encodes a raw code. The once section is followed by the repeat section.
+ir_parse_error encodeTimings(const ir_raw_code_t &raw, uint16_t *timings, uint16_t maxTimings, ir_timing_layout_t &layout);
+
+// Expands encoded timings into a timeline of 32 bit durations as the IR task
+// sends them: the once section followed by `repeat` repeat sections. A code
+// without once section starts with an extra repeat section. Split durations
+// are joined again. Returns the number of timings, 0 if they do not fit.
+uint16_t expandTimings(const uint16_t *timings, const ir_timing_layout_t &layout, uint16_t repeat,
+                       uint32_t *out, uint16_t maxOut);
+
+#endif
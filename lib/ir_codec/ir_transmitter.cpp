@@ -0,0 +1,110 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_transmitter.h"
+
+// Replays timings [start, end); even positions are marks, odd ones spaces.
+static void transmitTimings(IrTransmitter &tx, const uint16_t *timings, uint16_t start, uint16_t end)
+{
+    for (uint16_t i = start; i < end; i++)
+    {
+        if (i & 1)
+        {
+            tx.space(timings[i]);
+        }
+        else if (timings[i] > 0)
+        {
+            tx.mark(timings[i]);
+        }
+    }
+}
+
+// Start of the trailing gap of timings [start, end): spaces and empty marks at the end.
+static uint16_t trailingGapStart(const uint16_t *timings, uint16_t start, uint16_t end)
+{
+    while (end > start && ((end - 1) & 1 || timings[end - 1] == 0))
+    {
+        end--;
+    }
+    return end;
+}
+
+// Sends a frame up to its trailing gap. Returns the length of the gap.
+static uint32_t transmitFrame(IrTransmitter &tx, const uint16_t *timings, uint16_t start, uint16_t end)
+{
+    const uint16_t gapStart = trailingGapStart(timings, start, end);
+    transmitTimings(tx, timings, start, gapStart);
+    uint32_t gapUs = 0;
+    for (uint16_t i = gapStart; i < end; i++)
+    {
+        gapUs += timings[i];
+    }
+    return gapUs;
+}
+
+// Plays loops [first, last) straight from the stored timings, the last run
+// only up to its trailing gap. Returns the length of that gap.
+static uint32_t transmitLoops(IrTransmitter &tx, const uint16_t *timings, const ir_timing_layout_t &layout,
+                              uint8_t first, uint8_t last)
+{
+    uint32_t gapUs = 0;
+    tx.beginFrame();
+    for (uint8_t l = first; l < last; l++)
+    {
+        const ir_timing_loop_t &loop = layout.loops[l];
+        const uint16_t end = loop.start + loop.length;
+        for (uint16_t c = 1; c < loop.count; c++)
+        {
+            transmitTimings(tx, timings, loop.start, end);
+        }
+        if (l + 1 == last)
+        {
+            gapUs = transmitFrame(tx, timings, loop.start, end);
+            break;
+        }
+        transmitTimings(tx, timings, loop.start, end);
+    }
+    tx.endFrame();
+    return gapUs;
+}
+
+uint32_t transmitTimingCode(IrTransmitter &tx, const uint16_t *timings, const ir_timing_layout_t &layout,
+                            bool (*nextRepeat)(void *context), void *context)
+{
+    const uint8_t repeatLoop = layout.repeatLoop;
+    tx.enableIROut(layout.carrierHz);
+    // without a once section the repeat section is the first frame
+    uint32_t gapUs = transmitLoops(tx, timings, layout, 0, repeatLoop > 0 ? repeatLoop : layout.loopCount);
+    while (repeatLoop < layout.loopCount && nextRepeat(context))
+    {
+        tx.space(gapUs);
+        gapUs = transmitLoops(tx, timings, layout, repeatLoop, layout.loopCount);
+    }
+    return gapUs;
+}
+
+uint32_t transmitSegments(IrTransmitter &tx, const ir_segment_t *segments, uint16_t segmentCount,
+                          bool (*stopRequested)())
+{
+    uint32_t gapUs = 0;
+    tx.beginFrame();
+    for (uint16_t i = 0; i < segmentCount && !stopRequested(); i++)
+    {
+        const ir_segment_t &segment = segments[i];
+        if (segment.channels == 0)
+        {
+            if (i + 1 == segmentCount)
+            {
+                gapUs = segment.durationUs;
+            }
+            else
+            {
+                tx.space(segment.durationUs);
+            }
+            continue;
+        }
+        tx.setChannels(segment.channels);
+        tx.mark(segment.durationUs);
+    }
+    tx.endFrame();
+    return gapUs;
+}
@@ -0,0 +1,52 @@
+// Copyright 2024 Craig Petchell
+
+// Output of the IR task. The send path plays codes into a transmitter
+// backend: the dock drives its output pins (IrGpioTransmitter of ir_service),
+// native tests record what would have been sent (IrCaptureTransmitter).
+// Marks are sent on the carrier and the outputs set last, spaces keep every
+// output off.
+
+#ifndef IR_TRANSMITTER_H_
+#define IR_TRANSMITTER_H_
+
+#include <stdint.h>
+#include "ir_timing.h"
+#include "ir_timeline.h"
+
+class IrTransmitter
+{
+public:
+    virtual ~IrTransmitter() {}
+
+    virtual void enableIROut(uint32_t carrierHz) = 0;
+
+    // Outputs driven by the following marks, as channel bits (IR_CHANNEL_*)
+    virtual void setChannels(uint8_t channels) = 0;
+
+    virtual void mark(uint32_t durationUs) = 0;
+    virtual void space(uint32_t durationUs) = 0;
+
+    // Sends a protocol value with `repeats` repeat frames, or the state of an
+    // AC protocol, encoded by the backend. Returns false if the backend does
+    // not know the protocol.
+    virtual bool sendValue(int16_t decodeType, uint64_t value, uint16_t bits, uint16_t repeats) = 0;
+    virtual bool sendState(int16_t decodeType, const uint8_t *state, uint16_t length) = 0;
+
+    // Bracket every frame of a timing code, up to its trailing gap
+    virtual void beginFrame() {}
+    virtual void endFrame() {}
+};
+
+// Sends an encoded timing code: the once section, then the repeat section as
+// long as `nextRepeat` grants another one. A code without once section starts
+// with its repeat section. Returns the trailing gap of the last frame, which
+// is left to the caller so the next code can be prepared meanwhile.
+uint32_t transmitTimingCode(IrTransmitter &tx, const uint16_t *timings, const ir_timing_layout_t &layout,
+                            bool (*nextRepeat)(void *context), void *context);
+
+// Sends a merged schedule (see mergeTimelines) until `stopRequested` returns
+// true. Returns the last segment if all outputs are off in it, else 0.
+uint32_t transmitSegments(IrTransmitter &tx, const ir_segment_t *segments, uint16_t segmentCount,
+                          bool (*stopRequested)());
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_uccode.h"
+#include <stdio.h>
+#include <string.h>
+
+// Parses a decimal number of `len` digits. Returns false on empty or invalid input.
+static bool parseDecimal(const char *str, uint16_t len, uint32_t maxValue, uint16_t &value)
+{
+    if (len == 0)
+    {
+        return false;
+    }
+    uint32_t result = 0;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        const uint8_t digit = (uint8_t)(str[i] - '0');
+        if (digit > 9)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+        if (result > maxValue)
+        {
+            return false;
+        }
+    }
+    value = (uint16_t)result;
+    return true;
+}
+
+ir_parse_error parseUCCode(const char *text, uint16_t maxBits, uc_code_t &uc)
+{
+    if (text == nullptr || *text == 0)
+    {
+        return parse_empty;
+    }
+
+    const char *fields[4];
+    uint16_t lengths[4];
+    uint8_t fieldCount = 0;
+
+    const char *start = text;
+    const char *ptr = text;
+    for (;; ptr++)
+    {
+        if (*ptr == ';' || *ptr == 0)
+        {
+            if (fieldCount == 4)
+            {
+                // more than 4 fields
+                return parse_missing_field;
+            }
+            fields[fieldCount] = start;
+            lengths[fieldCount] = (uint16_t)(ptr - start);
+            fieldCount++;
+            if (*ptr == 0)
+            {
+                break;
+            }
+            start = ptr + 1;
+        }
+    }
+
+    if (fieldCount != 4)
+    {
+        return parse_missing_field;
+    }
+
+    if (lengths[0] == 0 || lengths[0] >= UC_MAX_PROTOCOL_LENGTH)
+    {
+        return parse_invalid_protocol;
+    }
+    memcpy(uc.protocol, fields[0], lengths[0]);
+    uc.protocol[lengths[0]] = 0;
+
+    if (lengths[1] == 0)
+    {
+        return parse_invalid_code;
+    }
+    uc.code = fields[1];
+    uc.codeLen = lengths[1];
+
+    if (!parseDecimal(fields[2], lengths[2], maxBits, uc.bits) || uc.bits == 0)
+    {
+        return parse_invalid_bits;
+    }
+
+    if (!parseDecimal(fields[3], lengths[3], UC_MAX_REPEATS, uc.repeats))
+    {
+        return parse_invalid_repeat;
+    }
+
+    return parse_ok;
+}
+
+bool formatUCCode(const char *protocol, const char *hex, uint16_t bits, uint16_t repeats, char *text, size_t size)
+{
+    const int length = snprintf(text, size, "%s;%s;%u;%u", protocol, hex, (unsigned)bits, (unsigned)repeats);
+    return length > 0 && (size_t)length < size;
+}
@@ -0,0 +1,33 @@
+// Copyright 2024 Craig Petchell
+
+// Splitting and writing of codes in UC format "protocol;code;bits;repeats"
+// without copying or heap allocation.
+
+#ifndef IR_UCCODE_H_
+#define IR_UCCODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ir_parse_error.h"
+
+#define UC_MAX_PROTOCOL_LENGTH 32
+#define UC_MAX_REPEATS 20
+
+typedef struct {
+    char protocol[UC_MAX_PROTOCOL_LENGTH];
+    const char *code;   // points into the parsed string, not terminated
+    uint16_t codeLen;
+    uint16_t bits;
+    uint16_t repeats;
+} uc_code_t;
+
+// Splits a UC code into its fields and validates the numeric ones.
+// `maxBits` is the largest number of bits accepted for the bits field.
+ir_parse_error parseUCCode(const char *text, uint16_t maxBits, uc_code_t &uc);
+
+// Writes a learned code as UC code, the way receiveIR reports it. `hex` is the
+// value or state as resultToHexidecimal writes it. Returns false if the code
+// does not fit into `size` bytes.
+bool formatUCCode(const char *protocol, const char *hex, uint16_t bits, uint16_t repeats, char *text, size_t size);
+
+#endif
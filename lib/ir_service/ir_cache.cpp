@@ -0,0 +1,80 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_cache.h"
+#include <string.h>
+#include <ir_seqlock.h>
+
+typedef struct {
+    uint64_t key;     // 0 marks an unused entry
+    uint32_t lastUse;
+    ir_message_t message;
+} ir_cache_entry_t;
+
+static ir_cache_entry_t cache[IR_CACHE_SIZE];
+static IrSeqlock<ir_cache_stats_t> stats;
+static uint32_t useCounter = 0;
+
+bool irCacheLookup(uint64_t key, ir_message_t &message)
+{
+    for (uint8_t i = 0; i < IR_CACHE_SIZE; i++)
+    {
+        if (cache[i].key == key)
+        {
+            cache[i].lastUse = ++useCounter;
+            memcpy(&message, &cache[i].message, sizeof(ir_message_t));
+            stats.beginUpdate().hits++;
+            stats.endUpdate();
+            return true;
+        }
+    }
+    stats.beginUpdate().misses++;
+    stats.endUpdate();
+    return false;
+}
+
+void irCacheStore(uint64_t key, const ir_message_t &message)
+{
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < IR_CACHE_SIZE; i++)
+    {
+        if (cache[i].key == key || cache[i].key == 0)
+        {
+            victim = i;
+            break;
+        }
+        if (cache[i].lastUse < cache[victim].lastUse)
+        {
+            victim = i;
+        }
+    }
+
+    ir_cache_stats_t &update = stats.beginUpdate();
+    if (cache[victim].key == 0)
+    {
+        update.entries++;
+    }
+    else if (cache[victim].key != key)
+    {
+        update.evictions++;
+    }
+    stats.endUpdate();
+
+    cache[victim].key = key;
+    cache[victim].lastUse = ++useCounter;
+    memcpy(&cache[victim].message, &message, sizeof(ir_message_t));
+}
+
+void irCacheClear()
+{
+    for (uint8_t i = 0; i < IR_CACHE_SIZE; i++)
+    {
+        cache[i].key = 0;
+    }
+    stats.beginUpdate().entries = 0;
+    stats.endUpdate();
+}
+
+void irCacheStats(ir_cache_stats_t &copy)
+{
+    stats.read(copy);
+}
@@ -0,0 +1,35 @@
+// Copyright 2024 Craig Petchell
+
+// Small LRU cache of already built IR messages, keyed by the fingerprint of
+// the (format, code) pair they were built from.
+
+#ifndef IR_CACHE_H_
+#define IR_CACHE_H_
+
+#include <stdint.h>
+#include "ir_message.h"
+
+#ifndef IR_CACHE_SIZE
+#define IR_CACHE_SIZE 8
+#endif
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint8_t entries;
+} ir_cache_stats_t;
+
+// Copies the cached payload for `key` into `message`. Returns false on a miss.
+bool irCacheLookup(uint64_t key, ir_message_t &message);
+
+// Stores the payload of `message` under `key`, evicting the least recently used entry if full.
+void irCacheStore(uint64_t key, const ir_message_t &message);
+
+void irCacheClear();
+
+// Copies the statistics. The cache is used by the task handling requests;
+// the statistics may be read from any task.
+void irCacheStats(ir_cache_stats_t &stats);
+
+#endif
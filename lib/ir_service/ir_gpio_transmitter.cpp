@@ -0,0 +1,176 @@
+// Copyright 2024 Craig Petchell
+
+#include <Arduino.h>
+#include "ir_gpio_transmitter.h"
+#include "ir_message.h"
+#include "ir_stats.h"
+
+#include <blaster_config.h>
+
+#if BLASTER_ENABLE_IR_JITTER == true
+// IRsend emits the frames of protocol values without a hook per edge. Each
+// frame is timed as a whole instead: a send starts the first one, each call of
+// the repeat callback ends a frame and starts the next one.
+static bool (*grantRepeat)() = NULL;
+static bool encodedSending = false;
+static uint32_t encodedStart = 0;
+static uint32_t encodedCode = 0;
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static void startEncodedFrames(uint32_t code)
+{
+    encodedCode = code;
+    encodedSending = true;
+    encodedStart = ESP.getCycleCount();
+}
+
+static void endEncodedFrame()
+{
+    if (encodedSending)
+    {
+        irJitterStats().encodedFrame(encodedStart, ESP.getCycleCount(), encodedCode);
+    }
+}
+
+// Repeat frames take other times than the first one: they count as another code.
+static bool timedRepeatCallback()
+{
+    endEncodedFrame();
+    const bool repeat = grantRepeat();
+    encodedSending = repeat && encodedSending;
+    encodedCode = encodedCode * 16777619UL + 1;
+    encodedStart = ESP.getCycleCount();
+    return repeat;
+}
+#endif
+
+IrGpioTransmitter::IrGpioTransmitter() : irsend(true, 0)
+{
+}
+
+void IrGpioTransmitter::begin(bool (*repeatCallback)())
+{
+#if BLASTER_ENABLE_IR_INTERNAL == true
+    pinMode(BLASTER_PIN_IR_INTERNAL, OUTPUT);
+#endif
+#if BLASTER_ENABLE_IR_OUT_1 == true
+    pinMode(BLASTER_PIN_IR_OUT_1, OUTPUT);
+#endif
+#if BLASTER_ENABLE_IR_OUT_2 == true
+    pinMode(BLASTER_PIN_IR_OUT_2, OUTPUT);
+#endif
+
+#if BLASTER_ENABLE_IR_JITTER == true
+    grantRepeat = repeatCallback;
+    irsend.setRepeatCallback(timedRepeatCallback);
+#else
+    irsend.setRepeatCallback(repeatCallback);
+#endif
+    irsend.begin();
+}
+
+void IrGpioTransmitter::enableIROut(uint32_t carrierHz)
+{
+    irsend.enableIROut(carrierHz);
+}
+
+void IrGpioTransmitter::setChannels(uint8_t channels)
+{
+    // pin indicator was removed from the ir mask.
+    // TODO: trigger some short flashing once a ir command is sent.
+    uint32_t ir_pin_mask = 0;
+    if (channels & IR_CHANNEL_INTERNAL)
+    {
+        ir_pin_mask |= 1 << BLASTER_PIN_IR_INTERNAL;
+    }
+    if (channels & IR_CHANNEL_EXT1)
+    {
+        ir_pin_mask |= 1 << BLASTER_PIN_IR_OUT_1;
+    }
+    if (channels & IR_CHANNEL_EXT2)
+    {
+        ir_pin_mask |= 1 << BLASTER_PIN_IR_OUT_2;
+    }
+    irsend.setPinMask(ir_pin_mask);
+}
+
+// The end of each mark and space is timestamped with the cycle counter
+// (BLASTER_ENABLE_IR_JITTER). Frames end before their trailing gap, which is
+// not part of the schedule.
+void IrGpioTransmitter::mark(uint32_t durationUs)
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    const uint32_t intendedUs = durationUs;
+#endif
+    // mark() is limited to 16 bit durations
+    while (durationUs > 0)
+    {
+        const uint16_t part = durationUs > UINT16_MAX ? UINT16_MAX : durationUs;
+        irsend.mark(part);
+        durationUs -= part;
+    }
+#if BLASTER_ENABLE_IR_JITTER == true
+    irJitterStats().edge(ESP.getCycleCount(), intendedUs);
+#endif
+}
+
+void IrGpioTransmitter::space(uint32_t durationUs)
+{
+    irsend.space(durationUs);
+#if BLASTER_ENABLE_IR_JITTER == true
+    irJitterStats().edge(ESP.getCycleCount(), durationUs);
+#endif
+}
+
+bool IrGpioTransmitter::sendValue(int16_t decodeType, uint64_t value, uint16_t bits, uint16_t repeats)
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    uint32_t code = fnv1a(2166136261UL, &decodeType, sizeof(decodeType));
+    code = fnv1a(code, &value, sizeof(value));
+    code = fnv1a(code, &bits, sizeof(bits));
+    startEncodedFrames(fnv1a(code, &repeats, sizeof(repeats)));
+    const bool sent = irsend.send((decode_type_t)decodeType, value, bits, repeats);
+    endEncodedFrame();
+    encodedSending = false;
+    return sent;
+#else
+    return irsend.send((decode_type_t)decodeType, value, bits, repeats);
+#endif
+}
+
+bool IrGpioTransmitter::sendState(int16_t decodeType, const uint8_t *state, uint16_t length)
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    const uint32_t code = fnv1a(2166136261UL, &decodeType, sizeof(decodeType));
+    startEncodedFrames(fnv1a(code, state, length));
+    const bool sent = irsend.send((decode_type_t)decodeType, state, length);
+    endEncodedFrame();
+    encodedSending = false;
+    return sent;
+#else
+    return irsend.send((decode_type_t)decodeType, state, length);
+#endif
+}
+
+void IrGpioTransmitter::beginFrame()
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    irJitterStats().startFrame(ESP.getCycleCount());
+#endif
+}
+
+void IrGpioTransmitter::endFrame()
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    irJitterStats().endFrame();
+#endif
+}
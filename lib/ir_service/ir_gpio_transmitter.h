@@ -0,0 +1,35 @@
+// Copyright 2024 Craig Petchell
+
+// Transmitter backend of the dock: IRsend bit-bangs the carrier on the
+// output pins of the selected channels. Protocol values are encoded by the
+// protocol encoders of IRremoteESP8266.
+
+#ifndef IR_GPIO_TRANSMITTER_H_
+#define IR_GPIO_TRANSMITTER_H_
+
+#include <IRsend.h>
+#include <ir_transmitter.h>
+
+class IrGpioTransmitter : public IrTransmitter
+{
+public:
+    IrGpioTransmitter();
+
+    // Sets up the output pins. IRsend asks `repeatCallback` whether to send
+    // another repeat frame of a protocol value.
+    void begin(bool (*repeatCallback)());
+
+    void enableIROut(uint32_t carrierHz) override;
+    void setChannels(uint8_t channels) override;
+    void mark(uint32_t durationUs) override;
+    void space(uint32_t durationUs) override;
+    bool sendValue(int16_t decodeType, uint64_t value, uint16_t bits, uint16_t repeats) override;
+    bool sendState(int16_t decodeType, const uint8_t *state, uint16_t length) override;
+    void beginFrame() override;
+    void endFrame() override;
+
+private:
+    IRsend irsend;
+};
+
+#endif
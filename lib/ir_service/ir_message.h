@@ -5,19 +5,28 @@
 
 #include <Arduino.h>
 #include <IRsend.h>
+#include <ir_timing.h>
 
-#define MAX_IR_CODE_LENGTH 2048
+// Room for 512 timings of an encoded code (repeated bursts are stored once),
+// or the state of the longest AC protocol
+#define MAX_IR_CODE_LENGTH 1024
+
+// IR outputs of the dock
+#define IR_CHANNEL_INTERNAL 0x01
+#define IR_CHANNEL_EXT1 0x02
+#define IR_CHANNEL_EXT2 0x04
+
+class AsyncWebSocket;
 
 enum ir_action {
     stop,
     send,
-    repeat,
     learn_start,
     learn_stop,
 };
 
 enum ir_format {
-    pronto,
+    timing, // code16 holds mark/space durations in us, see ir_timing.h
     hex
 };
 
@@ -31,10 +40,45 @@ typedef struct {
     };
     uint16_t codeLen;
     decode_type_t decodeType;
-    uint16_t repeat = 0;
+    // timing format: carrier and loops over the stored timings
+    ir_timing_layout_t timingLayout;
     bool ir_internal;
     bool ir_ext1;
     bool ir_ext2;
+    // sequences: pool slot of the following message and pause before it
+    uint8_t next;
+    uint16_t delayMs;
 } ir_message_t;
 
+// Item passed through irQueueHandle. The code payload of a send action lives
+// in a slot of the message pool (see ir_queue.h); the item only carries the
+// slot index, control actions carry no payload at all.
+typedef struct {
+    ir_action action;
+    uint8_t slot;
+    uint32_t queuedAt; // micros() when the item was queued
+    int32_t reqId;     // id of the originating request
+    bool parallel;     // the codes of the chain go out at the same time on their own outputs
+    uint32_t holdId;   // ir_hold_start: repeat until this hold ends; 0 = no hold
+    uint32_t holdTimeoutMs;
+    // set if the client asked for an ir_send_done event or started learning
+    AsyncWebSocket *wsServer;
+    uint32_t wsClientId;
+} ir_queue_item_t;
+
+// Outcome of a send action, reported by the ir_send_done event
+typedef struct {
+    int32_t reqId;
+    int code;          // 200, 503 if none of the requested channels is available, 422 if
+                       // ir_send_channels codes cannot be merged into one schedule
+    bool stopped;      // ended early by ir_stop
+    uint64_t startUs;  // first edge
+    uint64_t endUs;
+    // Repeat frames granted to the send: the repeats of the request, of later
+    // ir_send requests and of a hold. Protocol encoders may send more frames,
+    // e.g. the minimum repeats of Sony, so this is no count of frames sent.
+    uint16_t repeatsGranted;
+    uint8_t channels;  // IR_CHANNEL_* bits actually driven
+} ir_send_result_t;
+
 #endif
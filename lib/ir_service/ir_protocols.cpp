@@ -0,0 +1,42 @@
+// Copyright 2024 Craig Petchell
+
+#include <Arduino.h>
+#include "ir_protocols.h"
+
+#include <IRtext.h>
+#include <ir_protocol_index.h>
+
+static const IrProtocolIndex &protocolIndex()
+{
+    // built on first use; requests come from the web and the bluetooth task,
+    // the initialization of local statics is thread safe
+    static const IrProtocolIndex index(kAllProtocolNamesStr);
+    return index;
+}
+
+decode_type_t irDecodeType(const char *protocol)
+{
+    const int16_t type = protocolIndex().find(protocol);
+    if (type >= 0)
+    {
+        return (decode_type_t)type;
+    }
+
+    uint32_t number = 0;
+    const char *ptr = protocol;
+    for (; *ptr >= '0' && *ptr <= '9' && number <= kLastDecodeType; ptr++)
+    {
+        number = number * 10 + (*ptr - '0');
+    }
+    if (ptr == protocol || *ptr != 0 || number > kLastDecodeType)
+    {
+        return decode_type_t::UNKNOWN;
+    }
+    return (decode_type_t)number;
+}
+
+const char *irProtocolName(decode_type_t type)
+{
+    const char *name = protocolIndex().name(type);
+    return name != NULL ? name : "UNKNOWN";
+}
@@ -0,0 +1,18 @@
+// Copyright 2024 Craig Petchell
+
+// Protocol names of hex codes, resolved through a hash index over the names
+// of IRremoteESP8266 instead of its linear strToDecodeType.
+
+#ifndef IR_PROTOCOLS_H_
+#define IR_PROTOCOLS_H_
+
+#include <IRremoteESP8266.h>
+
+// Protocol of a name (any case) or of a protocol number, as learned codes of
+// older firmware carry it. UNKNOWN if there is none.
+decode_type_t irDecodeType(const char *protocol);
+
+// Name of a protocol, "UNKNOWN" if there is none.
+const char *irProtocolName(decode_type_t type);
+
+#endif
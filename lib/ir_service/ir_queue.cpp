@@ -0,0 +1,253 @@
+// Copyright 2024 Craig Petchell
+
+#include "ir_queue.h"
+
+#include <ir_slot_allocator.h>
+#include <atomic>
+
+static ir_message_t messagePool[IR_POOL_SIZE];
+static IrRepeatBudget repeatBudgets[IR_POOL_SIZE];
+static IrSlotAllocator slotAllocator(IR_POOL_SIZE);
+static std::atomic<bool> stopRequested(false);
+static std::atomic<uint8_t> queuedSends(0);
+static std::atomic<uint8_t> state(ir_idle);
+static std::atomic<uint32_t> lastHoldId(0);
+
+// The active hold; the request side and the IR task change it together
+static portMUX_TYPE holdLock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t holdId = 0;
+static uint32_t holdTimeoutMs = 0;
+static uint32_t holdDeadline = 0;
+// false while the held code waits in the queue, its deadline is not running yet
+static bool holdStarted = true;
+
+static uint32_t nowMs()
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// true once `deadline` is reached, robust against wrap around of the tick count
+static bool deadlinePassed(uint32_t deadline, uint32_t now)
+{
+    return (int32_t)(deadline - now) <= 0;
+}
+
+uint8_t irPoolAcquire()
+{
+    return slotAllocator.acquire();
+}
+
+void irPoolRelease(uint8_t slot)
+{
+    if (slot < IR_POOL_SIZE)
+    {
+        repeatBudgets[slot].close();
+    }
+    slotAllocator.release(slot);
+}
+
+ir_message_t &irPoolMessage(uint8_t slot)
+{
+    return messagePool[slot];
+}
+
+IrRepeatBudget &irRepeatBudget(uint8_t slot)
+{
+    return repeatBudgets[slot];
+}
+
+void irPoolReleaseChain(uint8_t slot)
+{
+    while (slot != IR_NO_SLOT)
+    {
+        const uint8_t next = messagePool[slot].next;
+        irPoolRelease(slot);
+        slot = next;
+    }
+}
+
+void irRequestStop()
+{
+    stopRequested = true;
+    if (irTaskHandle != NULL)
+    {
+        // wake the IR task if it is waiting between the codes of a sequence
+        xTaskNotifyGive(irTaskHandle);
+    }
+}
+
+bool irStopRequested()
+{
+    return stopRequested;
+}
+
+void irClearStop()
+{
+    stopRequested = false;
+}
+
+ir_state irState()
+{
+    return (ir_state)state.load();
+}
+
+bool irTransition(ir_state from, ir_state to)
+{
+    uint8_t expected = from;
+    return state.compare_exchange_strong(expected, to);
+}
+
+// true if hold `id` was created after hold `than`, robust against wrap around
+static bool holdNewer(uint32_t id, uint32_t than)
+{
+    return (int32_t)(id - than) > 0;
+}
+
+uint32_t irHoldCreate()
+{
+    uint32_t id = ++lastHoldId;
+    if (id == 0)
+    {
+        id = ++lastHoldId;
+    }
+    return id;
+}
+
+void irHoldQueued(uint32_t id, uint32_t timeoutMs)
+{
+    portENTER_CRITICAL(&holdLock);
+    // the IR task may have started the hold already
+    if (holdNewer(id, holdId))
+    {
+        holdId = id;
+        holdTimeoutMs = timeoutMs;
+        holdStarted = false;
+    }
+    portEXIT_CRITICAL(&holdLock);
+}
+
+void irHoldStart(uint32_t id, uint32_t timeoutMs)
+{
+    portENTER_CRITICAL(&holdLock);
+    if (holdNewer(id, holdId))
+    {
+        holdId = id;
+        holdTimeoutMs = timeoutMs;
+        holdStarted = false;
+    }
+    if (id == holdId && !holdStarted)
+    {
+        // keepalives that came in while it was waiting set the timeout
+        holdDeadline = nowMs() + holdTimeoutMs;
+        holdStarted = true;
+    }
+    portEXIT_CRITICAL(&holdLock);
+}
+
+bool irHoldExtend(uint32_t timeoutMs)
+{
+    const uint32_t now = nowMs();
+    bool active = true;
+    portENTER_CRITICAL(&holdLock);
+    if (!holdStarted)
+    {
+        holdTimeoutMs = timeoutMs;
+    }
+    else if (deadlinePassed(holdDeadline, now))
+    {
+        active = false;
+    }
+    else
+    {
+        holdDeadline = now + timeoutMs;
+    }
+    portEXIT_CRITICAL(&holdLock);
+    return active;
+}
+
+bool irHoldActive(uint32_t id)
+{
+    const uint32_t now = nowMs();
+    portENTER_CRITICAL(&holdLock);
+    const bool active = id != 0 && id == holdId && (!holdStarted || !deadlinePassed(holdDeadline, now));
+    portEXIT_CRITICAL(&holdLock);
+    return active;
+}
+
+void irHoldRelease()
+{
+    const uint32_t now = nowMs();
+    portENTER_CRITICAL(&holdLock);
+    holdDeadline = now;
+    holdStarted = true;
+    portEXIT_CRITICAL(&holdLock);
+}
+
+uint8_t irQueuedSends()
+{
+    return queuedSends;
+}
+
+bool irSendActive()
+{
+    const ir_state current = irState();
+    return current == ir_transmitting || current == ir_repeating;
+}
+
+void irSendQueued()
+{
+    queuedSends++;
+}
+
+void irSendUnqueued()
+{
+    queuedSends--;
+}
+
+void irSendStarted()
+{
+    // sends are only queued while not learning or storing, see learnIRStart() and
+    // beginIRStoreWrite(); a store write that got in first ends on its own
+    while (!irTransition(ir_idle, ir_transmitting))
+    {
+        vTaskDelay(1);
+    }
+    queuedSends--;
+}
+
+void irSendFinished()
+{
+    if (!irTransition(ir_transmitting, ir_idle))
+    {
+        irTransition(ir_repeating, ir_idle);
+    }
+}
+
+bool irDropOldestSend()
+{
+    ir_queue_item_t item;
+    if (irQueueHandle == NULL || xQueueReceive(irQueueHandle, &item, 0) != pdPASS)
+    {
+        return false;
+    }
+    if (item.action != send)
+    {
+        // keep stop and learn actions; put them back where they were
+        xQueueSendToFront(irQueueHandle, &item, 0);
+        return false;
+    }
+    if (item.holdId != 0)
+    {
+        // the hold never starts; keepalives for it must fail from now on
+        portENTER_CRITICAL(&holdLock);
+        if (item.holdId == holdId)
+        {
+            holdDeadline = nowMs();
+            holdStarted = true;
+        }
+        portEXIT_CRITICAL(&holdLock);
+    }
+    irPoolReleaseChain(item.slot);
+    irSendUnqueued();
+    return true;
+}
@@ -5,18 +5,100 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/task.h>
 
-// 1 for current IR code; 1 for stop; don't allow more than one IR code at a time.
-#define IR_QUEUE_SIZE 2
+#include "ir_message.h"
+#include <ir_slot_allocator.h>
+#include <ir_repeat_budget.h>
+#include <blaster_config.h>
+
+// Pending sends plus room for a stop and a learn action
+#define IR_QUEUE_SIZE (BLASTER_IR_QUEUE_DEPTH + 2)
+
+// Max number of codes in one ir_send_sequence
+#define IR_MAX_SEQUENCE_LENGTH 8
+
+// Max number of codes in one ir_send_channels, one per IR output
+#define IR_MAX_CHANNEL_CODES 3
+
+// Message slots: enough for a complete sequence plus the queued sends.
+#define IR_POOL_SIZE (BLASTER_IR_QUEUE_DEPTH + IR_MAX_SEQUENCE_LENGTH)
+
+// States of the IR service. The IR task moves between idle, transmitting and
+// repeating while it sends; learn requests move between idle and learning,
+// writes to the code store between idle and storing.
+enum ir_state {
+    ir_idle,
+    ir_transmitting,
+    ir_repeating,
+    ir_learning,
+    ir_storing,
+};
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern QueueHandle_t irQueueHandle;
+extern TaskHandle_t irTaskHandle;
+// TaskWeb, whose stack get_sysinfo reports
+extern TaskHandle_t webTaskHandle;
 
 #ifdef __cplusplus
 }
 #endif
 
+// Returns a free message slot or IR_NO_SLOT if all slots are in use.
+uint8_t irPoolAcquire();
+
+// Returns a slot to the pool once its message is no longer needed. Closes
+// the repeat budget of the slot.
+void irPoolRelease(uint8_t slot);
+
+ir_message_t &irPoolMessage(uint8_t slot);
+
+// Repeats owed to the message in `slot`. Opened when the send is built,
+// taken from by the IR task while sending.
+IrRepeatBudget &irRepeatBudget(uint8_t slot);
+
+// Releases `slot` and all slots linked to it via ir_message_t::next.
+void irPoolReleaseChain(uint8_t slot);
+
+// Aborts the running transmission or sequence. Called before queueing a stop action,
+// the IR task clears the request when it processes that stop action.
+void irRequestStop();
+bool irStopRequested();
+void irClearStop();
+
+ir_state irState();
+
+// Moves from `from` to `to` in one step. Returns false if the state was not `from`.
+bool irTransition(ir_state from, ir_state to);
+
+// Press-and-hold. The IR task keeps sending repeat frames of a held code until
+// the hold times out or is released; keepalives move the timeout.
+// irHoldCreate() returns the id for a new hold. Once its send is queued,
+// irHoldQueued() makes it replace any previous one. The timeout starts when
+// the IR task takes the send from the queue and calls irHoldStart().
+uint32_t irHoldCreate();
+void irHoldQueued(uint32_t id, uint32_t timeoutMs);
+void irHoldStart(uint32_t id, uint32_t timeoutMs);
+// Returns false if no hold is active any more.
+bool irHoldExtend(uint32_t timeoutMs);
+bool irHoldActive(uint32_t holdId);
+void irHoldRelease();
+
+// Bookkeeping of send actions; a send counts as queued until the IR task picks it up.
+// irSendStarted() and irSendFinished() move the state to transmitting and back to idle.
+uint8_t irQueuedSends();
+bool irSendActive();
+void irSendQueued();
+void irSendUnqueued();
+void irSendStarted();
+void irSendFinished();
+
+// Removes the oldest waiting send from the queue and ends its hold, if it
+// has one. Returns false if the head of the queue is no send action.
+bool irDropOldestSend();
+
 #endif // 
@@ -4,80 +4,153 @@
 #include "ir_service.h"
 #include "ir_queue.h"
 #include "ir_message.h"
+#include "ir_cache.h"
+#include "ir_stats.h"
+#include "ir_protocols.h"
+#include "ir_store.h"
 
 #include <api_service.h>
+#include <ir_formats.h>
+#include <ir_timing.h>
+#include <ir_recognizer.h>
+#include <ir_hex.h>
+#include <ir_uccode.h>
+#include <ir_fingerprint.h>
+#include <ir_timeline.h>
 #include <IRutils.h>
 
 static const char * TAG = "irservice";
 
 
 #define MAX_IR_TEXT_CODE_LENGTH 2048
-#define MAX_IR_FORMAT_TYPE 50
-
-// Current text ir code
-char irCode[MAX_IR_TEXT_CODE_LENGTH] = "";
-char irFormat[MAX_IR_FORMAT_TYPE] = "";
-
-bool irLearningActive=false;
-
-void buildProntoMessage(ir_message_t &message)
+// Durations of a timing based code before encoding, as many as the longest
+// pronto code text has words
+#define MAX_IR_RAW_DURATIONS (MAX_IR_TEXT_CODE_LENGTH / 2)
+// Longest pause accepted between two codes of a sequence
+#define IR_MAX_SEQUENCE_DELAY_MS 10000
+// Longest hold timeout a request may ask for
+#define IR_MAX_HOLD_TIMEOUT_MS 2000
+
+// Fingerprint of the current ir code; 0 if none
+uint64_t irFingerprint = 0;
+// Pool slot and repeat budget ticket of that code
+uint8_t irLastSlot = IR_NO_SLOT;
+uint16_t irLastTicket = 0;
+
+// Scratch buffers of buildTimingMessage. The raw durations and the uncompressed
+// timings need more room than a message keeps. Requests are handled one at a
+// time, by the websocket handler or, without network, by the bluetooth task.
+static uint32_t rawDurations[MAX_IR_RAW_DURATIONS];
+static uint16_t rawTimings[MAX_IR_RAW_DURATIONS];
+
+// Protocols a recognized pronto code may be sent as
+bool canSendNative(decode_type_t type)
 {
-    const int strCodeLen = strlen(irCode);
-
-    char workingCode[strCodeLen + 1] = "";
-    char *workingPtr;
-    message.codeLen = (strCodeLen + 1) / 5;
-    uint16_t offset = 0;
+    switch (type)
+    {
+    case decode_type_t::NEC:
+        return SEND_NEC;
+    case decode_type_t::SAMSUNG:
+        return SEND_SAMSUNG;
+    case decode_type_t::SONY:
+        return SEND_SONY;
+    case decode_type_t::RC5:
+    case decode_type_t::RC5X:
+        return SEND_RC5;
+    case decode_type_t::RC6:
+        return SEND_RC6;
+    default:
+        return false;
+    }
+}
 
-    strcpy(workingCode, irCode);
-    
-    char delimiter[2] = {0,0};
-    delimiter[0] = workingCode[4];
-    if((delimiter[0] != ' ') && (delimiter[0] != ','))
+// Turns a timing code that is a plain frame of a known protocol into a hex
+// message. It takes a few bytes instead of the timings and is sent with the
+// repeat frames of its protocol. Returns false to send the code as it is.
+bool buildNativeMessage(const ir_raw_code_t &raw, ir_message_t &message)
+{
+    ir_native_code_t native;
+    if (!recognizeIRCode(raw, native))
     {
-        ESP_LOGE(TAG, "Pronto delimiter not recognized. Prontocode: %s", workingCode);
+        return false;
     }
-    
-    char *hexCode = strtok_r(workingCode, delimiter, &workingPtr);
-    while (hexCode)
+    const decode_type_t type = irDecodeType(native.protocol);
+    if (!canSendNative(type))
     {
-        message.code16[offset++] = strtoul(hexCode, NULL, 16);
-        hexCode = strtok_r(NULL, delimiter, &workingPtr);
+        return false;
     }
 
-    message.format = pronto;
+    ESP_LOGD(TAG, "Timing code recognized as %s 0x%llx (%u bits)", native.protocol, (unsigned long long)native.value, native.bits);
+    message.code64 = native.value;
+    message.codeLen = native.bits;
+    message.format = hex;
     message.action = send;
-    message.decodeType = PRONTO;
+    message.decodeType = type;
+    return true;
 }
 
-void buildHexMessage(ir_message_t &message)
+// The native form of a timing code that is sent as protocol value, as UC code
+// to be sent with format hex. Empty if the code is sent as it is.
+String irNativeCode(const char *format, const ir_message_t &message)
 {
-    // Split the UC_CODE parameter into protocol / code / bits / repeats
-    char workingCode[MAX_IR_TEXT_CODE_LENGTH];
-    char *parts[4];
-    int partcount = 0;
+    if (format == NULL || strcmp("hex", format) == 0 || message.format != hex)
+    {
+        return String();
+    }
+    return String(irProtocolName(message.decodeType)) + ";0x" + uint64ToString(message.code64, 16) + ";" +
+           String(message.codeLen) + ";0";
+}
 
-    strcpy(workingCode, irCode);
-    parts[partcount++] = workingCode;
+// Parses a code of a timing format and encodes it into mark/space durations
+// right here on the request side, so the IR task only has to replay them.
+ir_parse_error buildTimingMessage(const ir_format_handler_t &handler, const char *irCode, ir_message_t &message)
+{
+    ir_raw_code_t raw = {0, rawDurations, 0, 0, MAX_IR_RAW_DURATIONS};
+    ir_parse_error err = handler.parse(irCode, raw);
+    if (err != parse_ok)
+    {
+        ESP_LOGE(TAG, "Invalid %s code (%s): %s", handler.name, irParseErrorToString(err), irCode);
+        return err;
+    }
 
-    char *ptr = workingCode;
-    while (*ptr && partcount < 4)
+#if BLASTER_IR_RECOGNIZE_NATIVE == true
+    if (buildNativeMessage(raw, message))
     {
-        if (*ptr == ';')
-        {
-            *ptr = 0;
-            parts[partcount++] = ptr + 1;
-        }
-        ptr++;
+        return parse_ok;
     }
+#endif
 
-    if (partcount != 4)
+    err = encodeTimings(raw, rawTimings, MAX_IR_RAW_DURATIONS, message.timingLayout);
+    if (err == parse_ok && message.timingLayout.length > MAX_IR_CODE_LENGTH / 2)
     {
-        ESP_LOGE(TAG, "Unvalid UC code");
-        return;
+        err = parse_too_long;
     }
+    if (err != parse_ok)
+    {
+        ESP_LOGE(TAG, "%s code too long to encode: %s", handler.name, irCode);
+        return err;
+    }
+    memcpy(message.code16, rawTimings, message.timingLayout.length * sizeof(uint16_t));
 
-    message.decodeType = strToDecodeType(parts[0]);
+    message.codeLen = message.timingLayout.length;
+    message.format = timing;
+    message.action = send;
+    message.decodeType = decode_type_t::RAW;
+    return parse_ok;
+}
+
+ir_parse_error buildHexMessage(const char *irCode, ir_message_t &message)
+{
+    // Split the UC_CODE parameter into protocol / code / bits / repeats
+    uc_code_t uc;
+    ir_parse_error err = parseUCCode(irCode, kStateSizeMax * 8, uc);
+    if (err != parse_ok)
+    {
+        ESP_LOGE(TAG, "Invalid UC code (%s): %s", irParseErrorToString(err), irCode);
+        return err;
+    }
+
+    message.decodeType = irDecodeType(uc.protocol);
 
     switch (message.decodeType)
     {
@@ -87,101 +160,155 @@ void buildHexMessage(ir_message_t &message)
     case decode_type_t::GLOBALCACHE:
     case decode_type_t::PRONTO:
     case decode_type_t::RAW:
-        ESP_LOGE(TAG, "The protocol specified is not supported by this program.");
-        return;
+        ESP_LOGE(TAG, "The protocol %s is not supported by this program.", uc.protocol);
+        return parse_invalid_protocol;
     default:
         break;
     }
 
-    uint16_t nbits = static_cast<uint16_t>(std::stoul(parts[2]));
-    if (nbits == 0 && (nbits <= kStateSizeMax * 8))
+    if (!hasACState(message.decodeType))
     {
-        ESP_LOGE(TAG, "No of bits %s is invalid", parts[2]);
-        return;
+        if (uc.bits > 64)
+        {
+            ESP_LOGE(TAG, "No of bits %u is invalid", uc.bits);
+            return parse_invalid_bits;
+        }
+        err = decodeHexValue(uc.code, uc.codeLen, message.code64);
+        message.codeLen = uc.bits;
     }
-
-    uint16_t stateSize = nbits / 8;
-
-    uint16_t repeats = static_cast<uint16_t>(std::stoul(parts[3]));
-    if (repeats > 20)
+    else
     {
-        ESP_LOGE(TAG, "Repeat count is too large: %d. Maximum is 20.", repeats);
-        return;
+        const uint16_t stateSize = uc.bits / 8;
+        if (stateSize == 0)
+        {
+            ESP_LOGE(TAG, "No of bits %u is invalid", uc.bits);
+            return parse_invalid_bits;
+        }
+        err = decodeHexState(uc.code, uc.codeLen, message.code8, stateSize);
+        message.codeLen = stateSize;
     }
 
-    if (!hasACState(message.decodeType))
+    if (err != parse_ok)
     {
-        message.code64 = std::stoull(parts[1], nullptr, 16);
-        message.codeLen = nbits;
+        ESP_LOGE(TAG, "Code %.*s is invalid (%s)", uc.codeLen, uc.code, irParseErrorToString(err));
+        return err;
     }
-    else
-    {
 
-        String hexstr = String(parts[1]);
-        uint64_t hexstrlength = hexstr.length();
-        uint64_t strOffset = 0;
-        if (hexstrlength > 1 && hexstr[0] == '0' &&
-            (hexstr[1] == 'x' || hexstr[1] == 'X'))
-        {
-            // Skip 0x/0X
-            strOffset = 2;
-        }
+    message.format = hex;
+    message.action = send;
+    return parse_ok;
+}
 
-        hexstrlength -= strOffset;
+ir_queue_item_t makeIRQueueItem(ir_action action, uint8_t slot = IR_NO_SLOT)
+{
+    ir_queue_item_t item;
+    memset(&item, 0, sizeof(item));
+    item.action = action;
+    item.slot = slot;
+    return item;
+}
 
-        memset(&message.code8, 0, stateSize);
-        message.codeLen = stateSize;
+// Remembers the requesting client, if it asked to be notified once the send is done.
+void setIRSendDoneClient(JsonDocument &input, AsyncWebSocketClient *wsClient, ir_queue_item_t &item)
+{
+    item.reqId = input["id"].as<int32_t>();
+    if (wsClient != NULL && input["notify_done"].as<bool>())
+    {
+        item.wsServer = wsClient->server();
+        item.wsClientId = wsClient->id();
+    }
+}
 
-        // Ptr to the least significant byte of the resulting state for this
-        // protocol.
-        uint8_t *statePtr = &message.code8[stateSize - 1];
+// Number of sends ahead of a newly queued one
+uint8_t irQueuePosition()
+{
+    return irQueuedSends() + (irSendActive() ? 1 : 0);
+}
 
-        // Convert the string into a state array of the correct length.
-        for (uint64_t i = 0; i < hexstrlength; i++)
-        {
-            // Grab the next least sigificant hexadecimal digit from the string.
-            uint8_t c = tolower(hexstr[hexstrlength + strOffset - i - 1]);
-            if (isxdigit(c))
-            {
-                if (isdigit(c))
-                    c -= '0';
-                else
-                    c = c - 'a' + 10;
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Code %s contains non-hexidecimal characters.", parts[1]);
-                return;
-            }
-            if (i % 2 == 1)
-            { // Odd: Upper half of the byte.
-                *statePtr += (c << 4);
-                statePtr--; // Advance up to the next least significant byte of state.
-            }
-            else
-            { // Even: Lower half of the byte.
-                *statePtr = c;
-            }
-        }
+// Sends neither interrupt learning nor a write to the code store. Replies 503 during either.
+bool irSendAllowed(JsonDocument &input, JsonDocument &output)
+{
+    switch (irState())
+    {
+    case ir_learning:
+        api_replyWithError(input, output, 503, "Canot send IR command. IR learning in progress.");
+        ESP_LOGE(TAG, "Canot send IR command. IR learning in progress.");
+        return false;
+    case ir_storing:
+        api_replyWithError(input, output, 503, "Cannot send IR command. IR code store is being written.");
+        ESP_LOGE(TAG, "Cannot send IR command. IR code store is being written.");
+        return false;
+    default:
+        return true;
     }
+}
 
-    message.format = hex;
-    message.action = send;
+// Checks, before the message is built, whether BLASTER_IR_QUEUE_POLICY accepts one more send.
+// Returns false if the send has to be rejected.
+bool reserveIRQueueEntry()
+{
+#if BLASTER_IR_QUEUE_POLICY == IR_QUEUE_POLICY_SINGLE
+    return irQueuePosition() == 0;
+#elif BLASTER_IR_QUEUE_POLICY == IR_QUEUE_POLICY_DROP_OLDEST
+    // room is made once the message is built, see makeIRQueueRoom()
+    return true;
+#else
+    return irQueuedSends() < BLASTER_IR_QUEUE_DEPTH;
+#endif
+}
+
+// Makes room for a built send right before it is queued. With IR_QUEUE_POLICY_DROP_OLDEST
+// the oldest waiting send gives way if the queue is full. Returns false if there is no room.
+bool makeIRQueueRoom()
+{
+    if (irQueuedSends() < BLASTER_IR_QUEUE_DEPTH)
+    {
+        return true;
+    }
+#if BLASTER_IR_QUEUE_POLICY == IR_QUEUE_POLICY_DROP_OLDEST
+    if (irDropOldestSend())
+    {
+        ESP_LOGW(TAG, "IR queue full. Dropped oldest waiting code.");
+        return true;
+    }
+#endif
+    return false;
 }
 
-bool queueIRMessage(ir_message_t &message, int waitingTime_ms=0)
+// Queues `item` for the IR task. For a send, `position` receives the number of sends ahead of it.
+bool queueIRMessage(ir_queue_item_t &item, int waitingTime_ms=0, uint8_t *position=NULL)
 {
 
     if (irQueueHandle != NULL)
     {
-        int ret = xQueueSend(irQueueHandle, (void *)&message, waitingTime_ms / portTICK_PERIOD_MS);
+        item.queuedAt = micros();
+        if (item.action == send)
+        {
+            // the message is built already, only now an older one may give way
+            if (!makeIRQueueRoom())
+            {
+                ESP_LOGE(TAG, "IR queue full");
+                return false;
+            }
+            if (position != NULL)
+            {
+                *position = irQueuePosition();
+            }
+            // count before sending, the IR task may pick the item up immediately
+            irSendQueued();
+        }
+        int ret = xQueueSend(irQueueHandle, (void *)&item, waitingTime_ms / portTICK_PERIOD_MS);
         if (ret == pdTRUE)
         {
             // The message was successfully sent.
             ESP_LOGD(TAG, "Action successfully sent to the IR Queue");
             return true;
         }
-        else if (ret == errQUEUE_FULL)
+        if (item.action == send)
+        {
+            irSendUnqueued();
+        }
+        if (ret == errQUEUE_FULL)
         {
             ESP_LOGE(TAG, "The `TaskWeb` was unable to send message to IR Queue");
         }
@@ -193,131 +320,683 @@ bool queueIRMessage(ir_message_t &message, int waitingTime_ms=0)
     return false;
 }
 
-AsyncWebSocketClient *learningClient;
 void learnIRStart(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
 {
-    //backup old learning state
-    bool irLearningOld = irLearningActive;
-
-    // block other potential ir commands
-    // TODO: is this really safe, or do we need stronger synchronization mechanisms between parallel requests?
-    irLearningActive = true;
+    // block other ir commands. Learning can only start while no code is waiting or being sent,
+    // as the IR task would otherwise send it while learning.
+    if (irState() != ir_learning && (irQueuePosition() != 0 || !irTransition(ir_idle, ir_learning)))
+    {
+        api_replyWithError(input, output, 503, "IR learning could not be triggered. IR sending in progress.");
+        ESP_LOGE(TAG, "IR learning could not be triggered. IR sending in progress.");
+        return;
+    }
 
-    ir_message_t message;
-    message.action = learn_start;
-    if(!queueIRMessage(message, 500)){
+    ir_queue_item_t item = makeIRQueueItem(learn_start);
+    if (wsClient != NULL)
+    {
+        // the IR task responds the learned IR code to this client
+        item.wsServer = wsClient->server();
+        item.wsClientId = wsClient->id();
+    }
+    if(!queueIRMessage(item, 500)){
         api_replyWithError(input, output, 503, "IR learning could not be triggered");
         ESP_LOGE(TAG, "IR learning could not be triggered");
-        //restore learning
-        irLearningActive = irLearningOld;
-    } 
-    else 
-    {
-        //save ws Client to respond the learned IR code
-        learningClient = wsClient;
+        irTransition(ir_learning, ir_idle);
     }
 }
 
 void learnIRStop(JsonDocument &input, JsonDocument &output)
 {
-    ir_message_t message;
-    message.action = learn_stop;
-    if(!queueIRMessage(message, 500)){
+    ir_queue_item_t item = makeIRQueueItem(learn_stop);
+    if(!queueIRMessage(item, 500)){
         api_replyWithError(input, output, 503, "IR learning could not be released");
         ESP_LOGE(TAG, "IR learning could not be released");
     } else {
-        irLearningActive = false;
-        learningClient = NULL;
+        irTransition(ir_learning, ir_idle);
+    }
+}
+
+
+// Builds the message for (format, code), reusing an earlier build from the cache if available.
+ir_parse_error buildIRMessage(const char *format, const char *code, uint64_t fingerprint, ir_message_t &message)
+{
+    if (irCacheLookup(fingerprint, message))
+    {
+        return parse_ok;
+    }
+
+    if (code == NULL)
+    {
+        return parse_empty;
+    }
+
+    if (strlen(code) + 1 > MAX_IR_TEXT_CODE_LENGTH)
+    {
+        ESP_LOGE(TAG, "Length of sent code is longer than allocated buffer. Length = %u; Max = %u", strlen(code), MAX_IR_TEXT_CODE_LENGTH);
+        return parse_too_long;
     }
+
+    ir_parse_error err;
+    const ir_format_handler_t *handler = findIRFormat(format);
+    if (format != NULL && strcmp("hex", format) == 0)
+    {
+        err = buildHexMessage(code, message);
+    }
+    else if (handler != NULL)
+    {
+        err = buildTimingMessage(*handler, code, message);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Unknown IR format %s", format ? format : "");
+        return parse_unknown_format;
+    }
+
+    if (err == parse_ok)
+    {
+        irCacheStore(fingerprint, message);
+    }
+    return err;
 }
 
+// Applies channel selection and repeat count of an ir_send request or sequence step
+// to the message in `slot`. Returns the ticket of its repeat budget.
+uint16_t applyIRSendOptions(JsonObject options, uint8_t slot)
+{
+    ir_message_t &message = irPoolMessage(slot);
+    message.action = send;
+    message.ir_internal = options["int_side"] || options["int_top"];
+    message.ir_ext1 = options["ext1"];
+    message.ir_ext2 = options["ext2"];
+    message.next = IR_NO_SLOT;
+    message.delayMs = 0;
+    return irRepeatBudget(slot).open(options["repeat"].as<uint16_t>());
+}
+
+// Same message as the last one still pending: extend its repeats. Once the IR
+// task has closed its budget, the code is sent again instead.
+bool addIRRepeats(uint64_t fingerprint, uint16_t repeat)
+{
+#if BLASTER_IR_QUEUE_POLICY == IR_QUEUE_POLICY_SINGLE || BLASTER_IR_QUEUE_POLICY == IR_QUEUE_POLICY_COALESCE
+    return irQueuePosition() != 0 && fingerprint == irFingerprint && irRepeatBudget(irLastSlot).add(irLastTicket, repeat);
+#else
+    return false;
+#endif
+}
+
+// Queues the single code built in `slot` and fills the response. The slot is
+// released if the code cannot be queued.
+bool queueIRSlot(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient, uint8_t slot,
+                 uint64_t fingerprint)
+{
+    irLastTicket = applyIRSendOptions(input.as<JsonObject>(), slot);
+    irLastSlot = slot;
+    irFingerprint = fingerprint;
+
+    uint8_t position = 0;
+    ir_queue_item_t item = makeIRQueueItem(send, slot);
+    setIRSendDoneClient(input, wsClient, item);
+    if (!queueIRMessage(item, 0, &position))
+    {
+        irPoolRelease(slot);
+        api_fillDefaultResponseFields(input, output, 429);
+        return false;
+    }
+    api_fillDefaultResponseFields(input, output);
+    output["queue_position"] = position;
+    return true;
+}
 
-void queueIR(JsonDocument &input, JsonDocument &output)
+void queueIR(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
 {
     const char *newCode = input["code"];
     const char *newFormat = input["format"];
     const uint16_t newRepeat = input["repeat"];
-    const bool ir_internal = input["int_side"] || input["int_top"];
-    const bool ir_ext1 = input["ext1"];
-    const bool ir_ext2 = input["ext2"];
-    ir_message_t message;
 
-    message.action = send;
-    message.ir_internal = ir_internal;
-    message.ir_ext1 = ir_ext1;
-    message.ir_ext2 = ir_ext2;
-    message.repeat = newRepeat;
+    if (!irSendAllowed(input, output))
+    {
+        return;
+    }
 
-    if(irLearningActive){
-        api_replyWithError(input, output, 503, "Canot send IR command. IR learning in progress.");
-        ESP_LOGE(TAG, "Canot send IR command. IR learning in progress.");
+    const uint64_t newFingerprint = irCodeFingerprint(newFormat, newCode);
+
+    if (addIRRepeats(newFingerprint, newRepeat))
+    {
+        api_fillDefaultResponseFields(input, output, 202);
+        return;
+    }
+
+    if (!reserveIRQueueEntry())
+    {
+        // Different message - reject
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+
+    // build the message directly in its pool slot
+    const uint8_t slot = irPoolAcquire();
+    if (slot == IR_NO_SLOT)
+    {
+        ESP_LOGE(TAG, "No free IR message slot");
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    ir_message_t &message = irPoolMessage(slot);
+
+    ir_parse_error err = buildIRMessage(newFormat, newCode, newFingerprint, message);
+    if (err != parse_ok)
+    {
+        api_replyWithError(input, output, 400, irParseErrorToString(err));
+        irPoolRelease(slot);
+        irFingerprint = 0;
+        irLastSlot = IR_NO_SLOT;
         return;
     }
 
+    // the IR task may release the message as soon as it is queued
+    const String nativeCode = irNativeCode(newFormat, message);
+    if (queueIRSlot(input, output, wsClient, slot, newFingerprint) && nativeCode.length() > 0)
+    {
+        output["native_code"] = nativeCode;
+    }
+}
+
+// Response code of a failed code store operation
+int irStoreStatus(ir_store_error err)
+{
+    switch (err)
+    {
+    case store_not_found:
+        return 404;
+    case store_unavailable:
+    case store_flash_error:
+        return 503;
+    case store_full:
+        return 507;
+    default:
+        return 400;
+    }
+}
+
+// Writing the flash stalls both cores, which would distort a transmission, and
+// learning must not be interrupted. Moves the IR service from idle to storing
+// in one step, like learnIRStart(), or replies 503.
+bool beginIRStoreWrite(JsonDocument &input, JsonDocument &output, const char *action)
+{
+    if (irState() == ir_learning)
+    {
+        api_replyWithError(input, output, 503, String("Cannot ") + action + " IR code. IR learning in progress.");
+        return false;
+    }
+    if (irQueuePosition() != 0 || !irTransition(ir_idle, ir_storing))
+    {
+        api_replyWithError(input, output, 503, String("Cannot ") + action + " IR code. IR sending in progress.");
+        return false;
+    }
+    return true;
+}
 
-    if (uxQueueMessagesWaiting(irQueueHandle) != 0) 
+void endIRStoreWrite()
+{
+    irTransition(ir_storing, ir_idle);
+}
+
+void storeIRCode(JsonDocument &input, JsonDocument &output)
+{
+    const char *code = input["code"];
+    const char *format = input["format"];
+    uint16_t id = input["code_id"].as<uint16_t>();
+
+    if (!beginIRStoreWrite(input, output, "store"))
     {
-        // Message being processed
-        if(irCode[0] && (strcmp(newCode, irCode) == 0) && (strcmp(newFormat, irFormat) == 0))
+        return;
+    }
+
+    // built like a code to send, in a pool slot
+    const uint8_t slot = irPoolAcquire();
+    if (slot == IR_NO_SLOT)
+    {
+        endIRStoreWrite();
+        ESP_LOGE(TAG, "No free IR message slot");
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    ir_message_t &message = irPoolMessage(slot);
+    ir_parse_error err = buildIRMessage(format, code, irCodeFingerprint(format, code), message);
+    if (err != parse_ok)
+    {
+        endIRStoreWrite();
+        irPoolRelease(slot);
+        api_replyWithError(input, output, 400, irParseErrorToString(err));
+        return;
+    }
+    const String nativeCode = irNativeCode(format, message);
+    const ir_store_error storeErr = irStoreSave(id, input["name"].as<const char *>(), message);
+    endIRStoreWrite();
+    irPoolRelease(slot);
+    if (storeErr != store_ok)
+    {
+        api_replyWithError(input, output, irStoreStatus(storeErr), irStoreErrorToString(storeErr));
+        return;
+    }
+    api_fillDefaultResponseFields(input, output);
+    output["code_id"] = id;
+    if (nativeCode.length() > 0)
+    {
+        output["native_code"] = nativeCode;
+    }
+}
+
+void queueIRById(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
+{
+    if (!irSendAllowed(input, output))
+    {
+        return;
+    }
+
+    const uint8_t slot = irPoolAcquire();
+    if (slot == IR_NO_SLOT)
+    {
+        ESP_LOGE(TAG, "No free IR message slot");
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    uint64_t fingerprint = 0;
+    const ir_store_error err = irStoreLoad(input["code_id"].as<uint16_t>(), input["name"].as<const char *>(), irPoolMessage(slot), fingerprint);
+    if (err != store_ok)
+    {
+        irPoolRelease(slot);
+        api_replyWithError(input, output, irStoreStatus(err), irStoreErrorToString(err));
+        return;
+    }
+
+    if (addIRRepeats(fingerprint, input["repeat"].as<uint16_t>()))
+    {
+        irPoolRelease(slot);
+        api_fillDefaultResponseFields(input, output, 202);
+        return;
+    }
+    if (!reserveIRQueueEntry())
+    {
+        irPoolRelease(slot);
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    queueIRSlot(input, output, wsClient, slot, fingerprint);
+}
+
+void deleteIRCode(JsonDocument &input, JsonDocument &output)
+{
+    if (!beginIRStoreWrite(input, output, "delete"))
+    {
+        return;
+    }
+    const ir_store_error err = irStoreDelete(input["code_id"].as<uint16_t>(), input["name"].as<const char *>());
+    endIRStoreWrite();
+    if (err != store_ok)
+    {
+        api_replyWithError(input, output, irStoreStatus(err), irStoreErrorToString(err));
+        return;
+    }
+    api_fillDefaultResponseFields(input, output);
+}
+
+void listIRCodes(JsonDocument &input, JsonDocument &output)
+{
+    const ir_store_error err = irStoreList(output);
+    if (err != store_ok)
+    {
+        api_replyWithError(input, output, irStoreStatus(err), irStoreErrorToString(err));
+        return;
+    }
+    api_fillDefaultResponseFields(input, output);
+}
+
+// Builds all codes up front and links their slots in order, so the IR task
+// can play them back without further parsing. Returns the first slot of the
+// chain, or IR_NO_SLOT after replying with the error.
+uint8_t buildIRChain(JsonArray codes, const String &label, JsonDocument &input, JsonDocument &output)
+{
+    uint8_t first = IR_NO_SLOT;
+    uint8_t last = IR_NO_SLOT;
+    uint8_t index = 0;
+    for (JsonObject step : codes)
+    {
+        const uint8_t slot = irPoolAcquire();
+        if (slot == IR_NO_SLOT)
         {
-            // Same message. send repeat command
-            api_fillDefaultResponseFields(input, output, 202);
-            message.action = repeat;
-            queueIRMessage(message);
-            return;
+            ESP_LOGE(TAG, "No free IR message slot");
+            irPoolReleaseChain(first);
+            api_fillDefaultResponseFields(input, output, 429);
+            return IR_NO_SLOT;
+        }
+        ir_message_t &message = irPoolMessage(slot);
+        // keep the chain consistent for irPoolReleaseChain on errors
+        message.next = IR_NO_SLOT;
+        if (last == IR_NO_SLOT)
+        {
+            first = slot;
         }
         else
         {
-            // Different message - reject
-            api_fillDefaultResponseFields(input, output, 429);
+            irPoolMessage(last).next = slot;
+        }
+        last = slot;
+
+        const char *code = step["code"];
+        const char *format = step["format"];
+        ir_parse_error err = buildIRMessage(format, code, irCodeFingerprint(format, code), message);
+        if (err != parse_ok)
+        {
+            irPoolReleaseChain(first);
+            api_replyWithError(input, output, 400, label + String(index) + ": " + irParseErrorToString(err));
+            return IR_NO_SLOT;
+        }
+
+        const uint8_t next = message.next;
+        applyIRSendOptions(step, slot);
+        message.next = next;
+        const uint32_t delayMs = step["delay"].as<uint32_t>();
+        message.delayMs = delayMs > IR_MAX_SEQUENCE_DELAY_MS ? IR_MAX_SEQUENCE_DELAY_MS : delayMs;
+        index++;
+    }
+    return first;
+}
+
+void queueIRSequence(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
+{
+    JsonArray sequence = input["sequence"].as<JsonArray>();
+
+    if (!irSendAllowed(input, output))
+    {
+        return;
+    }
+
+    if (sequence.isNull() || sequence.size() == 0 || sequence.size() > IR_MAX_SEQUENCE_LENGTH)
+    {
+        api_replyWithError(input, output, 400, "Sequence must contain 1 to " + String(IR_MAX_SEQUENCE_LENGTH) + " codes.");
+        return;
+    }
+
+    if (!reserveIRQueueEntry())
+    {
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+
+    const uint8_t first = buildIRChain(sequence, "Sequence code ", input, output);
+    if (first == IR_NO_SLOT)
+    {
+        return;
+    }
+
+    // repeats of a single code do not apply to sequences
+    irFingerprint = 0;
+
+    uint8_t position = 0;
+    ir_queue_item_t item = makeIRQueueItem(send, first);
+    setIRSendDoneClient(input, wsClient, item);
+    if (!queueIRMessage(item, 0, &position))
+    {
+        irPoolReleaseChain(first);
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    api_fillDefaultResponseFields(input, output);
+    output["queue_position"] = position;
+}
+
+void queueIRChannels(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
+{
+    JsonArray codes = input["codes"].as<JsonArray>();
+
+    if (!irSendAllowed(input, output))
+    {
+        return;
+    }
+
+    if (codes.isNull() || codes.size() == 0 || codes.size() > IR_MAX_CHANNEL_CODES)
+    {
+        api_replyWithError(input, output, 400, "Codes must contain 1 to " + String(IR_MAX_CHANNEL_CODES) + " entries.");
+        return;
+    }
+
+    if (!reserveIRQueueEntry())
+    {
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+
+    const uint8_t first = buildIRChain(codes, "Channel code ", input, output);
+    if (first == IR_NO_SLOT)
+    {
+        return;
+    }
+
+    // every output may only play one of the codes
+    bool internal = false;
+    bool ext1 = false;
+    bool ext2 = false;
+    for (uint8_t slot = first; slot != IR_NO_SLOT; slot = irPoolMessage(slot).next)
+    {
+        const ir_message_t &message = irPoolMessage(slot);
+        // hex codes are encoded inside IRsend and have no timeline to merge
+        if (message.format != timing ||
+            !carriersCompatible(irPoolMessage(first).timingLayout.carrierHz, message.timingLayout.carrierHz))
+        {
+            irPoolReleaseChain(first);
+            api_replyWithError(input, output, 400, "Channel codes must be timing codes on a common carrier.");
+            return;
+        }
+        if ((message.ir_internal && internal) || (message.ir_ext1 && ext1) || (message.ir_ext2 && ext2))
+        {
+            irPoolReleaseChain(first);
+            api_replyWithError(input, output, 400, "Each IR output can only be used by one code.");
             return;
         }
+        internal |= message.ir_internal;
+        ext1 |= message.ir_ext1;
+        ext2 |= message.ir_ext2;
+    }
+
+    irFingerprint = 0;
+
+    uint8_t position = 0;
+    ir_queue_item_t item = makeIRQueueItem(send, first);
+    item.parallel = true;
+    setIRSendDoneClient(input, wsClient, item);
+    if (!queueIRMessage(item, 0, &position))
+    {
+        irPoolReleaseChain(first);
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
+    }
+    api_fillDefaultResponseFields(input, output);
+    output["queue_position"] = position;
+}
+
+// Timeout of ir_hold_start and ir_hold_keepalive requests
+uint32_t irHoldTimeout(JsonDocument &input)
+{
+    const uint32_t timeoutMs = input["timeout"].isNull() ? BLASTER_IR_HOLD_TIMEOUT_MS : input["timeout"].as<uint32_t>();
+    return timeoutMs > IR_MAX_HOLD_TIMEOUT_MS ? IR_MAX_HOLD_TIMEOUT_MS : timeoutMs;
+}
+
+void holdIRStart(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient)
+{
+    const char *newCode = input["code"];
+    const char *newFormat = input["format"];
+
+    if (!irSendAllowed(input, output))
+    {
+        return;
+    }
+
+    if (!reserveIRQueueEntry())
+    {
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
     }
 
-    if (strlen(newCode)+1 > sizeof(irCode))
+    const uint8_t slot = irPoolAcquire();
+    if (slot == IR_NO_SLOT)
     {
-        ESP_LOGE(TAG, "Length of sent code is longer than allocated buffer. Length = %u; Max = %u", strlen(newCode), sizeof(irCode));
-        api_replyWithError(input, output, 400, "Length of IR code exceeds buffer.");
+        ESP_LOGE(TAG, "No free IR message slot");
+        api_fillDefaultResponseFields(input, output, 429);
         return;
     }
 
-    if (strlen(newFormat)+1 > sizeof(irFormat))
+    ir_parse_error err = buildIRMessage(newFormat, newCode, irCodeFingerprint(newFormat, newCode), irPoolMessage(slot));
+    if (err != parse_ok)
     {
-        ESP_LOGE(TAG, "Length of sent format is longer than allocated buffer. Length = %u; Max = %u", strlen(newFormat), sizeof(irFormat));
-        api_replyWithError(input, output, 400, "Length of IR code format exceeds buffer.");
+        api_replyWithError(input, output, 400, irParseErrorToString(err));
+        irPoolRelease(slot);
         return;
     }
+    applyIRSendOptions(input.as<JsonObject>(), slot);
 
-    strcpy(irCode, newCode);
-    strcpy(irFormat, newFormat);
+    // resending the held code must not add repeats behind the hold
+    irFingerprint = 0;
 
-    if (strcmp("hex", newFormat) == 0)
+    uint8_t position = 0;
+    ir_queue_item_t item = makeIRQueueItem(send, slot);
+    item.holdId = irHoldCreate();
+    item.holdTimeoutMs = irHoldTimeout(input);
+    setIRSendDoneClient(input, wsClient, item);
+    if (!queueIRMessage(item, 0, &position))
     {
-        buildHexMessage(message);
-        queueIRMessage(message);
-        api_fillDefaultResponseFields(input, output);
+        // the hold that is active keeps going
+        irPoolRelease(slot);
+        api_fillDefaultResponseFields(input, output, 429);
+        return;
     }
-    else if (strcmp("pronto", newFormat) == 0)
+    irHoldQueued(item.holdId, item.holdTimeoutMs);
+    api_fillDefaultResponseFields(input, output);
+    output["queue_position"] = position;
+}
+
+void holdIRKeepalive(JsonDocument &input, JsonDocument &output)
+{
+    if (!irHoldExtend(irHoldTimeout(input)))
     {
-        buildProntoMessage(message);
-        queueIRMessage(message);
-        api_fillDefaultResponseFields(input, output);
+        api_replyWithError(input, output, 409, "No IR hold active.");
+        return;
     }
-    else
+    api_fillDefaultResponseFields(input, output);
+}
+
+void holdIRStop(JsonDocument &input, JsonDocument &output)
+{
+    irHoldRelease();
+    api_fillDefaultResponseFields(input, output);
+}
+
+static const char *irStateToString(ir_state state)
+{
+    switch (state)
+    {
+    case ir_transmitting:
+        return "transmitting";
+    case ir_repeating:
+        return "repeating";
+    case ir_learning:
+        return "learning";
+    case ir_storing:
+        return "storing";
+    case ir_idle:
+    default:
+        return "idle";
+    }
+}
+
+void fillIRSysinfo(JsonDocument &output)
+{
+    output["ir_state"] = irStateToString(irState());
+
+    ir_cache_stats_t cacheStats;
+    irCacheStats(cacheStats);
+    JsonObject cache = output["ir_cache"].to<JsonObject>();
+    cache["size"] = IR_CACHE_SIZE;
+    cache["entries"] = cacheStats.entries;
+    cache["hits"] = cacheStats.hits;
+    cache["misses"] = cacheStats.misses;
+    cache["evictions"] = cacheStats.evictions;
+
+    ir_latency_stats_t latencyStats;
+    irSendLatencyStats(latencyStats);
+    JsonObject latency = output["ir_latency_us"].to<JsonObject>();
+    latency["count"] = latencyStats.count;
+    if (latencyStats.count > 0)
+    {
+        latency["last"] = latencyStats.lastUs;
+        latency["min"] = latencyStats.minUs;
+        latency["max"] = latencyStats.maxUs;
+        latency["avg"] = (uint32_t)(latencyStats.totalUs / latencyStats.count);
+    }
+
+    // least free stack since boot. Requests are handled in the AsyncTCP task,
+    // or in the BT task without network, not in TaskWeb.
+    JsonObject stack = output["stack_free_bytes"].to<JsonObject>();
+    if (irTaskHandle != NULL)
+    {
+        stack["ir"] = uxTaskGetStackHighWaterMark(irTaskHandle);
+    }
+    if (webTaskHandle != NULL)
+    {
+        stack["web"] = uxTaskGetStackHighWaterMark(webTaskHandle);
+    }
+    stack["request"] = uxTaskGetStackHighWaterMark(NULL);
+}
+
+void reportIRJitter(JsonDocument &input, JsonDocument &output)
+{
+#if BLASTER_ENABLE_IR_JITTER == true
+    ir_jitter_report_t report;
+    irJitterStats().report(report);
+    output["frames"] = report.frames;
+    output["edges"] = report.edges;
+    output["overruns"] = report.overruns;
+    output["overrun_frames"] = report.overrunFrames;
+    output["encoded_frames"] = report.encodedFrames;
+    output["overrun_limit_us"] = BLASTER_IR_JITTER_OVERRUN_US;
+
+    JsonObject window = output["window"].to<JsonObject>();
+    window["frames"] = report.windowFrames;
+    window["jitter_max_us"] = report.edgeMaxUs;
+    window["jitter_p99_us"] = report.edgeP99Us;
+    window["drift_max_us"] = report.frameMaxUs;
+    window["drift_p99_us"] = report.frameP99Us;
+    JsonArray jitter = window["jitter_histogram"].to<JsonArray>();
+    JsonArray drift = window["drift_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < IR_JITTER_BUCKETS; i++)
     {
-        ESP_LOGE(TAG, "Unknown IR format %s", newFormat);
-        api_replyWithError(input, output, 400, "Unknown IR format");
+        jitter.add(report.edgeHistogram[i]);
+        drift.add(report.frameHistogram[i]);
+    }
 
-        irCode[0] = 0;
-        irFormat[0] = 0;
+    if (input["reset"].as<bool>())
+    {
+        irJitterStats().requestReset();
     }
+    api_fillDefaultResponseFields(input, output);
+#else
+    api_replyWithError(input, output, 501, "IR jitter instrumentation is not part of this firmware");
+#endif
 }
 
 void stopIR(JsonDocument &input, JsonDocument &output)
 {
-    ir_message_t message;
-    message.action = stop;
+    ir_queue_item_t item = makeIRQueueItem(stop);
+
+    irRequestStop();
 
-    queueIRMessage(message);
+    // only the stop action clears the request; left set, it would skip every later send
+    if (!queueIRMessage(item))
+    {
+        irClearStop();
+        api_replyWithError(input, output, 503, "IR stop could not be queued");
+        ESP_LOGE(TAG, "IR stop could not be queued");
+        return;
+    }
     api_fillDefaultResponseFields(input, output);
 }
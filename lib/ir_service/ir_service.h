@@ -12,13 +12,39 @@
 #include <AsyncWebSocket.h>
 
 
-void queueIR(JsonDocument &input, JsonDocument &output);
+// wsClient receives an ir_send_done event after transmission if the request sets "notify_done".
+void queueIR(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient = NULL);
+
+void queueIRSequence(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient = NULL);
+
+// Sends a different code on each IR output at the same time.
+void queueIRChannels(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient = NULL);
 
 void stopIR(JsonDocument &input, JsonDocument &output);
 
+// Code store: ir_store builds a code and keeps it in flash under "code_id" and/or
+// "name", ir_send_id sends it like ir_send without parsing it again.
+void storeIRCode(JsonDocument &input, JsonDocument &output);
+void queueIRById(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient = NULL);
+void deleteIRCode(JsonDocument &input, JsonDocument &output);
+void listIRCodes(JsonDocument &input, JsonDocument &output);
+
+// Press-and-hold: ir_hold_start sends the code and keeps sending its repeat frames
+// until no ir_hold_keepalive arrived within the timeout, or ir_hold_stop.
+void holdIRStart(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient = NULL);
+void holdIRKeepalive(JsonDocument &input, JsonDocument &output);
+void holdIRStop(JsonDocument &input, JsonDocument &output);
+
 void learnIRStart(JsonDocument &input, JsonDocument &output, AsyncWebSocketClient *wsClient);
 
 void learnIRStop(JsonDocument &input, JsonDocument &output);
 
+// Adds statistics of the IR service to the get_sysinfo response.
+void fillIRSysinfo(JsonDocument &output);
+
+// Reports the timing errors of the emitted marks and spaces (BLASTER_ENABLE_IR_JITTER),
+// "reset": true clears them afterwards.
+void reportIRJitter(JsonDocument &input, JsonDocument &output);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+// Copyright 2024 Craig Petchell
+
+#include <Arduino.h>
+#include "ir_stats.h"
+
+#include <ir_seqlock.h>
+
+static IrSeqlock<ir_latency_stats_t> latencyStats;
+
+void irRecordSendLatency(uint32_t latencyUs)
+{
+    ir_latency_stats_t &stats = latencyStats.beginUpdate();
+    if (stats.count == 0 || latencyUs < stats.minUs)
+    {
+        stats.minUs = latencyUs;
+    }
+    if (latencyUs > stats.maxUs)
+    {
+        stats.maxUs = latencyUs;
+    }
+    stats.count++;
+    stats.lastUs = latencyUs;
+    stats.totalUs += latencyUs;
+    latencyStats.endUpdate();
+}
+
+void irSendLatencyStats(ir_latency_stats_t &stats)
+{
+    latencyStats.read(stats);
+}
+
+#if BLASTER_ENABLE_IR_JITTER == true
+IrJitterStats &irJitterStats()
+{
+    static IrJitterStats jitterStats(ESP.getCpuFreqMHz(), BLASTER_IR_JITTER_OVERRUN_US);
+    return jitterStats;
+}
+#endif
@@ -0,0 +1,35 @@
+// Copyright 2024 Craig Petchell
+
+// Runtime statistics of the IR task, reported via get_sysinfo. The IR task
+// updates them while requests read them on the other core.
+
+#ifndef IR_STATS_H_
+#define IR_STATS_H_
+
+#include <stdint.h>
+#include <blaster_config.h>
+#if BLASTER_ENABLE_IR_JITTER == true
+#include <ir_jitter.h>
+#endif
+
+// Time from queueing an IR command until its transmission starts
+typedef struct {
+    uint32_t count;
+    uint32_t lastUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+} ir_latency_stats_t;
+
+// Called by the IR task right before the first edge of a command is emitted.
+void irRecordSendLatency(uint32_t latencyUs);
+
+// Copies the statistics; min/max are undefined while count is 0.
+void irSendLatencyStats(ir_latency_stats_t &stats);
+
+#if BLASTER_ENABLE_IR_JITTER == true
+// Timing errors of the marks and spaces the IR task emits, in CPU cycles
+IrJitterStats &irJitterStats();
+#endif
+
+#endif
@@ -0,0 +1,292 @@
+// Copyright 2024 Craig Petchell
+
+#include <Arduino.h>
+#include "ir_store.h"
+#include "ir_protocols.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_partition.h>
+#include <IRutils.h>
+#include <ir_binary.h>
+#include <ir_fingerprint.h>
+
+static const char *TAG = "irstore";
+
+#define IR_STORE_PARTITION_LABEL "ircodes"
+// first subtype ESP-IDF leaves to applications
+#define IR_STORE_PARTITION_SUBTYPE 0x40
+
+// version, format, decode type, code length, then the code: the state of AC
+// protocols, the 64 bit value, or the timings in binary form (ir_binary.h)
+#define IR_STORED_VERSION 1
+#define IR_STORED_HEADER_SIZE 6
+#define IR_STORED_MAX_SIZE (IR_STORED_HEADER_SIZE + IR_BINARY_MAX_SIZE(MAX_IR_CODE_LENGTH / 2))
+
+static const esp_partition_t *partition = NULL;
+static IrCodeLog *codeLog = NULL;
+// requests come one at a time from a single context: the AsyncTCP task, or the
+// bluetooth task when there is no network. The lock does not rely on that.
+static SemaphoreHandle_t storeLock = NULL;
+
+static bool partitionWrite(void *context, uint32_t offset, const void *data, uint32_t length)
+{
+    return esp_partition_write((const esp_partition_t *)context, offset, data, length) == ESP_OK;
+}
+
+static bool partitionErase(void *context, uint32_t offset, uint32_t length)
+{
+    return esp_partition_erase_range((const esp_partition_t *)context, offset, length) == ESP_OK;
+}
+
+static uint8_t *put16(uint8_t *out, uint16_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+    return out + 2;
+}
+
+static uint16_t get16(const uint8_t *in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static uint8_t *put32(uint8_t *out, uint32_t value)
+{
+    return put16(put16(out, value & 0xFFFF), value >> 16);
+}
+
+static uint32_t get32(const uint8_t *in)
+{
+    return get16(in) | ((uint32_t)get16(in + 2) << 16);
+}
+
+// Serializes the code of a built message. Returns the bytes written, 0 if
+// the code cannot be stored.
+static uint16_t encodeStoredMessage(const ir_message_t &message, uint8_t *out)
+{
+    uint8_t *ptr = out;
+    *ptr++ = IR_STORED_VERSION;
+    *ptr++ = message.format;
+    ptr = put16(ptr, message.decodeType);
+    ptr = put16(ptr, message.codeLen);
+    if (message.format == timing)
+    {
+        const uint16_t length = encodeBinaryTimings(message.code16, message.timingLayout, ptr,
+                                                    IR_STORED_MAX_SIZE - IR_STORED_HEADER_SIZE);
+        if (length == 0)
+        {
+            return 0;
+        }
+        ptr += length;
+    }
+    else if (hasACState(message.decodeType))
+    {
+        memcpy(ptr, message.code8, message.codeLen);
+        ptr += message.codeLen;
+    }
+    else
+    {
+        ptr = put32(put32(ptr, message.code64 & 0xFFFFFFFF), message.code64 >> 32);
+    }
+    return ptr - out;
+}
+
+// Restores the code of a message from a stored payload. Payloads of another
+// version or that do not fit a message are rejected, in case the store was
+// written by other firmware.
+static bool decodeStoredMessage(const uint8_t *payload, uint16_t length, ir_message_t &message)
+{
+    if (length < IR_STORED_HEADER_SIZE || payload[0] != IR_STORED_VERSION)
+    {
+        return false;
+    }
+    const uint8_t *ptr = payload + 1;
+    const uint8_t *end = payload + length;
+    message.format = (ir_format)*ptr++;
+    message.decodeType = (decode_type_t)(int16_t)get16(ptr);
+    message.codeLen = get16(ptr + 2);
+    ptr += 4;
+
+    if (message.format == timing)
+    {
+        if (decodeBinaryTimings(ptr, end - ptr, message.code16, MAX_IR_CODE_LENGTH / 2, message.timingLayout) !=
+                parse_ok ||
+            message.timingLayout.length != message.codeLen)
+        {
+            return false;
+        }
+    }
+    else if (message.format != hex)
+    {
+        return false;
+    }
+    else if (hasACState(message.decodeType))
+    {
+        if (message.codeLen > MAX_IR_CODE_LENGTH || end - ptr != message.codeLen)
+        {
+            return false;
+        }
+        memcpy(message.code8, ptr, message.codeLen);
+    }
+    else
+    {
+        if (end - ptr != 8)
+        {
+            return false;
+        }
+        message.code64 = get32(ptr) | ((uint64_t)get32(ptr + 4) << 32);
+    }
+    message.action = send;
+    return true;
+}
+
+void irStoreInit()
+{
+    storeLock = xSemaphoreCreateMutex();
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)IR_STORE_PARTITION_SUBTYPE,
+                                         IR_STORE_PARTITION_LABEL);
+    if (partition == NULL)
+    {
+        ESP_LOGW(TAG, "No %s partition, IR code store not available", IR_STORE_PARTITION_LABEL);
+        return;
+    }
+
+    const void *mapped = NULL;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &handle) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Mapping the %s partition failed", IR_STORE_PARTITION_LABEL);
+        return;
+    }
+
+    const ir_flash_ops_t ops = {(void *)partition, partitionWrite, partitionErase};
+    codeLog = new IrCodeLog((const uint8_t *)mapped, partition->size, ops);
+    const ir_store_error err = codeLog->begin();
+    if (err != store_ok)
+    {
+        ESP_LOGE(TAG, "Opening the IR code store failed: %s", irStoreErrorToString(err));
+        return;
+    }
+    ESP_LOGI(TAG, "IR code store holds %u codes, %u of %u bytes used", codeLog->size(), (unsigned)codeLog->bytesUsed(),
+             (unsigned)codeLog->capacity());
+}
+
+// Finds the code of `id`, or of `name` if id is IR_LOG_NO_ID. Called with the lock held.
+static ir_store_error findStoredCode(uint16_t id, const char *name, ir_log_entry_t &entry)
+{
+    if (id != IR_LOG_NO_ID)
+    {
+        return codeLog->find(id, entry) ? store_ok : store_not_found;
+    }
+    if (name != NULL && name[0] != '\0')
+    {
+        return codeLog->findName(name, entry) ? store_ok : store_not_found;
+    }
+    return store_not_found;
+}
+
+ir_store_error irStoreSave(uint16_t &id, const char *name, const ir_message_t &message)
+{
+    if (codeLog == NULL)
+    {
+        return store_unavailable;
+    }
+    uint8_t *payload = (uint8_t *)malloc(IR_STORED_MAX_SIZE);
+    if (payload == NULL)
+    {
+        ESP_LOGE(TAG, "No memory to store IR code");
+        return store_too_large;
+    }
+    const uint16_t length = encodeStoredMessage(message, payload);
+    if (length == 0)
+    {
+        free(payload);
+        return store_too_large;
+    }
+
+    xSemaphoreTake(storeLock, portMAX_DELAY);
+    const ir_store_error err = codeLog->put(id, name, payload, length);
+    xSemaphoreGive(storeLock);
+    free(payload);
+    if (err == store_ok)
+    {
+        ESP_LOGD(TAG, "Stored IR code %u (%s), %u bytes", id, name ? name : "", length);
+    }
+    return err;
+}
+
+ir_store_error irStoreLoad(uint16_t id, const char *name, ir_message_t &message, uint64_t &fingerprint)
+{
+    if (codeLog == NULL)
+    {
+        return store_unavailable;
+    }
+    xSemaphoreTake(storeLock, portMAX_DELAY);
+    ir_log_entry_t entry;
+    ir_store_error err = findStoredCode(id, name, entry);
+    if (err == store_ok && !decodeStoredMessage(entry.payload, entry.length, message))
+    {
+        ESP_LOGE(TAG, "Stored IR code %u is damaged", entry.id);
+        err = store_not_found;
+    }
+    xSemaphoreGive(storeLock);
+    if (err == store_ok)
+    {
+        char key[24];
+        snprintf(key, sizeof(key), "%u:%08x", entry.id, (unsigned)entry.checksum);
+        fingerprint = irCodeFingerprint("store", key);
+    }
+    return err;
+}
+
+ir_store_error irStoreDelete(uint16_t id, const char *name)
+{
+    if (codeLog == NULL)
+    {
+        return store_unavailable;
+    }
+    xSemaphoreTake(storeLock, portMAX_DELAY);
+    ir_log_entry_t entry;
+    ir_store_error err = findStoredCode(id, name, entry);
+    if (err == store_ok)
+    {
+        err = codeLog->remove(entry.id);
+    }
+    xSemaphoreGive(storeLock);
+    return err;
+}
+
+ir_store_error irStoreList(JsonDocument &output)
+{
+    if (codeLog == NULL)
+    {
+        return store_unavailable;
+    }
+    JsonArray codes = output["codes"].to<JsonArray>();
+    xSemaphoreTake(storeLock, portMAX_DELAY);
+    ir_log_entry_t entry;
+    for (uint16_t i = 0; codeLog->at(i, entry); i++)
+    {
+        JsonObject code = codes.add<JsonObject>();
+        code["code_id"] = entry.id;
+        if (entry.name[0] != '\0')
+        {
+            code["name"] = entry.name;
+        }
+        if (entry.length >= IR_STORED_HEADER_SIZE && entry.payload[0] == IR_STORED_VERSION)
+        {
+            const bool isHex = entry.payload[1] == hex;
+            code["format"] = isHex ? "hex" : "timing";
+            if (isHex)
+            {
+                code["protocol"] = irProtocolName((decode_type_t)(int16_t)get16(entry.payload + 2));
+            }
+        }
+        code["bytes"] = entry.length;
+    }
+    output["bytes_used"] = codeLog->bytesUsed();
+    output["capacity"] = codeLog->capacity();
+    xSemaphoreGive(storeLock);
+    return store_ok;
+}
@@ -0,0 +1,29 @@
+// Copyright 2024 Craig Petchell
+
+// Persistent store of built IR messages in the "ircodes" flash partition,
+// so stored codes are sent by id or name without parsing them again.
+
+#ifndef IR_STORE_H_
+#define IR_STORE_H_
+
+#include <ArduinoJson.h>
+#include <ir_code_log.h>
+#include "ir_message.h"
+
+// Opens the code store partition. Without it (e.g. a partition table flashed
+// by older firmware) the store reports store_unavailable.
+void irStoreInit();
+
+// Stores `message` under `id` and `name` (may be empty), see IrCodeLog::put.
+ir_store_error irStoreSave(uint16_t &id, const char *name, const ir_message_t &message);
+
+// Copies the code stored under `id`, or under `name` if id is IR_LOG_NO_ID,
+// into `message`. `fingerprint` identifies the stored version of the code.
+ir_store_error irStoreLoad(uint16_t id, const char *name, ir_message_t &message, uint64_t &fingerprint);
+
+ir_store_error irStoreDelete(uint16_t id, const char *name);
+
+// Adds the stored codes and the usage of the store to an ir_list response.
+ir_store_error irStoreList(JsonDocument &output);
+
+#endif
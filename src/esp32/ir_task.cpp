@@ -6,23 +6,53 @@
 
 #include <freertos/FreeRTOS.h>
 
-#include <IRsend.h>
 #include <IRrecv.h>
 #include <IRutils.h>
 
 #include <ir_message.h>
 #include <ir_queue.h>
+#include <ir_protocols.h>
+#include <ir_stats.h>
+#include <ir_gpio_transmitter.h>
+#include <ir_timeline.h>
+#include <ir_timing.h>
+#include <ir_transmitter.h>
+#include <ir_uccode.h>
 #include <libconfig.h>
 #include <api_service.h>
 #include <blaster_config.h>
 
 #include <esp_log.h>
+#include <esp_timer.h>
 
 static const char *TAG = "irtask";
 
-uint16_t irRepeat = 0;
-ir_message_t repeatMessage;
-IRsend irsend(true, 0);
+// IRrecv offers no event to block on, so the receiver is polled with this period while learning.
+#define IR_LEARN_POLL_MS 10
+
+// Buffers for merging the codes of ir_send_channels
+#define IR_MERGE_MAX_TIMINGS 512
+#define IR_MERGE_MAX_SEGMENTS 1024
+// edges of different codes closer than this number of carrier periods cannot be reproduced
+#define IR_MERGE_MIN_SEGMENT_PERIODS 2
+
+// pool slot of the message being sent; its repeat budget feeds repeatCallback()
+uint8_t irActiveSlot = IR_NO_SLOT;
+// hold of the message being sent, 0 if it is no ir_hold_start
+uint32_t irActiveHold = 0;
+// The trailing space of the last frame is not waited for right away. The next
+// frame may start at this esp_timer time; until then the IR task finishes the
+// previous send and picks up and stages the next one.
+int64_t irGapEndUs = 0;
+// repeat frames granted to the current send, reported by the ir_send_done event
+uint16_t irRepeatsGranted = 0;
+// micros() when the current send was queued, whether its first edge went out and when
+uint32_t irSendQueuedAt = 0;
+bool irSendEmitting = false;
+int64_t irSendStartUs = 0;
+IrGpioTransmitter gpioTransmitter;
+// output of the IR task
+IrTransmitter &irTransmitter = gpioTransmitter;
 
 #if BLASTER_ENABLE_IR_LEARN == true
 const uint16_t irRecvBufferSize = 1024;
@@ -31,9 +61,15 @@ IRrecv irrecv(BLASTER_PIN_IR_LEARN, irRecvBufferSize, 15, true);
 
 bool repeatCallback()
 {
-    if (irRepeat > 0)
+    if (irStopRequested() || irActiveSlot == IR_NO_SLOT)
     {
-        irRepeat--;
+        return false;
+    }
+    // a hold repeats at the frame rate of the protocol until its timeout
+    if (irRepeatBudget(irActiveSlot).take() || irHoldActive(irActiveHold))
+    {
+        irTransition(ir_transmitting, ir_repeating);
+        irRepeatsGranted++;
         return true;
     }
     return false;
@@ -42,81 +78,344 @@ bool repeatCallback()
 void irSetup()
 {
     ESP_LOGD(TAG, "Setting up Pins for IR Sending");
-
-#if BLASTER_ENABLE_IR_INTERNAL == true
-    pinMode(BLASTER_PIN_IR_INTERNAL, OUTPUT);
-#endif
-#if BLASTER_ENABLE_IR_OUT_1 == true
-    pinMode(BLASTER_PIN_IR_OUT_1, OUTPUT);
-#endif
-#if BLASTER_ENABLE_IR_OUT_2 == true
-    pinMode(BLASTER_PIN_IR_OUT_2, OUTPUT);
-#endif
+    gpioTransmitter.begin(repeatCallback);
 
 #if BLASTER_ENABLE_IR_LEARN == true
     ESP_LOGD(TAG, "Setting up Pin for IR Lerning");
+#if DECODE_HASH
     irrecv.setUnknownThreshold(1000);
+#endif
     irrecv.enableIRIn();
     irrecv.pause();
 #endif
+}
+
+// Defers a trailing space: the next frame starts gapUs from now at the earliest.
+void deferGap(uint32_t gapUs)
+{
+    irGapEndUs = esp_timer_get_time() + gapUs;
+}
+
+// Called right before the first edge of a message goes out, after waitGap():
+// the send latency runs from queueing the send to its first edge, which
+// ir_send_done reports as start.
+void startEmitting()
+{
+    if (!irSendEmitting)
+    {
+        irSendEmitting = true;
+        irSendStartUs = esp_timer_get_time();
+        irRecordSendLatency(micros() - irSendQueuedAt);
+    }
+}
 
-    irsend.setRepeatCallback(repeatCallback);
-    irsend.begin();
+// Waits for the end of the trailing space of the previous frame.
+void waitGap()
+{
+    int64_t remainingUs = irGapEndUs - esp_timer_get_time();
+    if (remainingUs > 2000)
+    {
+        // sleep through most of a long gap, the last part is waited exactly
+        vTaskDelay((remainingUs / 1000 - 1) / portTICK_PERIOD_MS);
+        remainingUs = irGapEndUs - esp_timer_get_time();
+    }
+    if (remainingUs > 0)
+    {
+        delayMicroseconds(remainingUs);
+    }
 }
 
-void sendProntoCode(ir_message_t &message)
+// Grants the repeat frames of a timing code: first those owed, then as long
+// as the repeat callback grants more.
+bool nextTimingRepeat(void *context)
 {
-    irsend.sendPronto(message.code16, message.codeLen, message.repeat);
-    irRepeat = 0;
+    uint16_t &owed = *(uint16_t *)context;
+    if (irStopRequested())
+    {
+        return false;
+    }
+    if (owed > 0)
+    {
+        owed--;
+        irRepeatsGranted++;
+        return true;
+    }
+    return repeatCallback();
+}
+
+// Sends the once section of an encoded code, then its repeat section for
+// every repeat owed and as long as the repeat callback grants more, the same
+// way the protocol encoders of IRsend repeat hex codes. The durations were
+// encoded when the request came in, so nothing is computed between edges.
+// The gap after the last frame is left to waitGap().
+void sendTimingCode(ir_message_t &message, IrRepeatBudget &budget)
+{
+    uint16_t owed = budget.takeAll();
+    deferGap(transmitTimingCode(irTransmitter, message.code16, message.timingLayout, nextTimingRepeat, &owed));
 }
 
-void sendHexCode(ir_message_t &message)
+void sendHexCode(ir_message_t &message, IrRepeatBudget &budget)
 {
-    // Copy so not overritten on next message
-    memcpy(&repeatMessage, &message, sizeof(ir_message_t));
-    irRepeat = message.repeat;
+    bool sent;
     if (hasACState(message.decodeType))
     {
-        irsend.send(message.decodeType, message.code8, message.codeLen);
+        // state based protocols have no repeat argument, repeats only come from the callback
+        sent = irTransmitter.sendState(message.decodeType, message.code8, message.codeLen);
     }
     else
     {
-        irsend.send(message.decodeType, message.code64, message.codeLen, irRepeat);
+        // repeats owed so far go to the protocol, later ones through the callback
+        const uint16_t repeats = budget.takeAll();
+        irRepeatsGranted += repeats;
+        sent = irTransmitter.sendValue(message.decodeType, message.code64, message.codeLen, repeats);
+    }
+    if (!sent)
+    {
+        // left out by the ir_protocols profile of this build
+        ESP_LOGE(TAG, "Protocol %s is not part of this firmware", irProtocolName(message.decodeType));
     }
 }
 
 #if BLASTER_ENABLE_IR_LEARN == true
 String receiveIR()
 {
-    String code = "";
     decode_results irRes;
 
-    if (irrecv.decode(&irRes))
+    if (!irrecv.decode(&irRes))
     {
-        irrecv.pause();
+        return String();
+    }
+    irrecv.pause();
 
-        ESP_LOGV(TAG, resultToHumanReadableBasic(&irRes).c_str());
-        code += irRes.decode_type;
-        code += ";";
-        code += resultToHexidecimal(&irRes);
-        code += ";";
-        code += irRes.bits;
-        code += ";";
-        code += irRes.repeat;
-        ESP_LOGD(TAG, "Learned IR code in UC format: %d", code.c_str());
+    ESP_LOGV(TAG, resultToHumanReadableBasic(&irRes).c_str());
+    // the name, so the code stays valid if the library renumbers its protocols
+    char code[UC_MAX_PROTOCOL_LENGTH + 2 * kStateSizeMax + 24];
+    if (!formatUCCode(irProtocolName(irRes.decode_type), resultToHexidecimal(&irRes).c_str(), irRes.bits,
+                      irRes.repeat, code, sizeof(code)))
+    {
+        ESP_LOGE(TAG, "Learned IR code of %u bits is too long", irRes.bits);
+        return String();
     }
-    return code;
+    ESP_LOGD(TAG, "Learned IR code in UC format: %s", code);
+    return String(code);
 }
 #endif
 
+// Requested outputs of a message that exist in the dock configuration, as IR_CHANNEL_* bits.
+uint8_t availableChannels(const ir_message_t &message)
+{
+    uint8_t channels = 0;
+    if(message.ir_internal)
+    {
+        if(BLASTER_ENABLE_IR_INTERNAL == true)
+        {
+            channels |= IR_CHANNEL_INTERNAL;
+        }
+        else
+        {
+            ESP_LOGD(TAG, "Internal IR channel requested but not available in dock configuration");
+        }
+    }
+    if(message.ir_ext1)
+    {
+        if(BLASTER_ENABLE_IR_OUT_1 == true)
+        {
+            channels |= IR_CHANNEL_EXT1;
+        }
+        else
+        {
+            ESP_LOGD(TAG, "External IR channel 1 requested but not available in dock configuration");
+        }
+    }
+    if(message.ir_ext2)
+    {
+        if(BLASTER_ENABLE_IR_OUT_2 == true)
+        {
+            channels |= IR_CHANNEL_EXT2;
+        }
+        else
+        {
+            ESP_LOGD(TAG, "External IR channel 2 requested but not available in dock configuration");
+        }
+    }
+
+    // TODO: do we need to report back, if we are not sending the command?
+    // at least log a warning!
+    if (channels == 0)
+    {
+        ESP_LOGE(TAG, "IR command could not be sent. All IR channels requested for sending are not available in the dock configuration");
+        ESP_LOGD(TAG, "Requested channels: internal=%s, out_1=%s, out_2=%s", message.ir_internal?"true ":"false", message.ir_ext1?"true ":"false", message.ir_ext2?"true ":"false");
+        ESP_LOGD(TAG, "Available channels: internal=%s, out_1=%s, out_2=%s", BLASTER_ENABLE_IR_INTERNAL?"true ":"false", BLASTER_ENABLE_IR_OUT_1?"true ":"false", BLASTER_ENABLE_IR_OUT_2?"true ":"false");
+    }
+    return channels;
+}
+
+// Sends the message in `slot` on the channels it selects. Returns the IR_CHANNEL_* bits used, 0 if none is available.
+uint8_t transmitMessage(uint8_t slot)
+{
+    ir_message_t &message = irPoolMessage(slot);
+    const uint8_t channels = availableChannels(message);
+    if (channels == 0)
+    {
+        return 0;
+    }
+
+    waitGap();
+    irTransmitter.setChannels(channels);
+
+    irActiveSlot = slot;
+    startEmitting();
+    switch (message.format)
+    {
+    case timing:
+        sendTimingCode(message, irRepeatBudget(slot));
+        break;
+    case hex:
+        sendHexCode(message, irRepeatBudget(slot));
+        break;
+    }
+    // usually closed by the last take() already; a stop leaves it open
+    irRepeatBudget(slot).close();
+    irActiveSlot = IR_NO_SLOT;
+    irTransition(ir_repeating, ir_transmitting);
+    return channels;
+}
+
+// Merged schedule of ir_send_channels codes, built in the IR task right before sending
+uint32_t irMergeTimings[IR_MAX_CHANNEL_CODES][IR_MERGE_MAX_TIMINGS];
+ir_segment_t irMergeSegments[IR_MERGE_MAX_SEGMENTS];
+
+// Merges the timing codes of a chain into one schedule on a common carrier.
+// `repeats` receives the most repeats of any code in it. Returns false if the
+// codes cannot go out at the same time. The schedule is empty if none of the
+// requested outputs is available.
+bool mergeChannelCodes(uint8_t first, uint32_t &carrierHz, uint16_t &segmentCount, uint16_t &repeats)
+{
+    ir_timeline_t lines[IR_MAX_CHANNEL_CODES];
+    uint8_t lineCount = 0;
+    carrierHz = 0;
+    repeats = 0;
+    for (uint8_t slot = first; slot != IR_NO_SLOT; slot = irPoolMessage(slot).next)
+    {
+        const ir_message_t &message = irPoolMessage(slot);
+        // native protocols are encoded inside IRsend, there is no timeline to merge
+        if (message.format != timing || lineCount >= IR_MAX_CHANNEL_CODES)
+        {
+            return false;
+        }
+        const uint32_t hz = message.timingLayout.carrierHz;
+        if (carrierHz == 0)
+        {
+            carrierHz = hz;
+        }
+        else if (!carriersCompatible(carrierHz, hz))
+        {
+            return false;
+        }
+
+        const uint8_t channels = availableChannels(message);
+        if (channels == 0)
+        {
+            continue;
+        }
+        // the schedule is fixed from here on, later repeats go to a new send
+        const uint16_t slotRepeats = irRepeatBudget(slot).close();
+        if (slotRepeats > repeats)
+        {
+            repeats = slotRepeats;
+        }
+        const uint16_t count = expandTimings(message.code16, message.timingLayout, slotRepeats, irMergeTimings[lineCount], IR_MERGE_MAX_TIMINGS);
+        if (count == 0)
+        {
+            return false;
+        }
+        lines[lineCount].timings = irMergeTimings[lineCount];
+        lines[lineCount].count = count;
+        lines[lineCount].channels = channels;
+        lineCount++;
+    }
+    if (lineCount == 0)
+    {
+        segmentCount = 0;
+        return true;
+    }
+
+    const uint32_t minSegmentUs = IR_MERGE_MIN_SEGMENT_PERIODS * 1000000UL / carrierHz;
+    return mergeTimelines(lines, lineCount, minSegmentUs, irMergeSegments, IR_MERGE_MAX_SEGMENTS, segmentCount);
+}
+
+// Sends the codes of an ir_send_channels chain at the same time, each on its own
+// outputs. Returns the IR_CHANNEL_* bits used; `code` becomes 422 if the codes
+// cannot be merged into one schedule, nothing is sent then.
+uint8_t transmitParallel(uint8_t first, int &code)
+{
+    uint32_t carrierHz;
+    uint16_t segmentCount;
+    uint16_t repeats;
+    if (!mergeChannelCodes(first, carrierHz, segmentCount, repeats))
+    {
+        // sending them one after another would not be simultaneous
+        ESP_LOGE(TAG, "IR codes cannot be merged, edges too close or schedule too long");
+        code = 422;
+        return 0;
+    }
+    if (segmentCount == 0)
+    {
+        return 0;
+    }
+
+    uint8_t channels = 0;
+    for (uint16_t i = 0; i < segmentCount; i++)
+    {
+        channels |= irMergeSegments[i].channels;
+    }
+    waitGap();
+    irTransmitter.enableIROut(carrierHz);
+    startEmitting();
+    deferGap(transmitSegments(irTransmitter, irMergeSegments, segmentCount, irStopRequested));
+    irRepeatsGranted += repeats;
+    return channels;
+}
+
+// Waits the pause between two codes of a sequence. Returns false if a stop was requested meanwhile.
+bool waitSequenceDelay(uint16_t delayMs)
+{
+    // the pause starts after the gap of the previous code
+    waitGap();
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t delayTicks = delayMs / portTICK_PERIOD_MS;
+    TickType_t elapsed = 0;
+    while (!irStopRequested() && elapsed < delayTicks)
+    {
+        // irRequestStop() notifies the task, so a stop ends the wait early
+        ulTaskNotifyTake(pdTRUE, delayTicks - elapsed);
+        elapsed = xTaskGetTickCount() - start;
+    }
+    return !irStopRequested();
+}
+
 bool receiveIRState = false;
-// TODO: this definitely needs to be done nicer
-extern AsyncWebSocketClient *learningClient;
+// client that receives the learned code, taken from the learn_start action
+AsyncWebSocket *learningServer = NULL;
+uint32_t learningClientId = 0;
 
 // TODO: implement a nicer solution later than crossreferencing a function
 extern void setLedStateLearn();
 extern void setLedStateNormal();
 
+// Pushes the ir_send_done event to the client that asked for it, if it is still connected.
+void reportSendDone(const ir_queue_item_t &item, const ir_send_result_t &result)
+{
+    AsyncWebSocketClient *client = item.wsServer->client(item.wsClientId);
+    if (client == NULL)
+    {
+        ESP_LOGD(TAG, "Client of request %d disconnected before the send was done", result.reqId);
+        return;
+    }
+    JsonDocument eventMsg;
+    api_buildIRSendDoneEvent(eventMsg, result);
+    api_sendJsonReply(eventMsg, client);
+}
 
 
 
@@ -125,9 +424,11 @@ void TaskIR(void *pvParameters)
     ESP_LOGD(TAG, "TaskIR running on core %d", xPortGetCoreID());
 
     irSetup();
-    ir_message_t message;
+    ir_queue_item_t item;
     for (;;)
     {
+        // block until a command arrives; commands wake the task immediately
+        TickType_t waitTicks = portMAX_DELAY;
 
 #if BLASTER_ENABLE_IR_LEARN == true        
         if (receiveIRState)
@@ -138,92 +439,99 @@ void TaskIR(void *pvParameters)
                 // we learned an IR code. prepare for sending via websocket connection
                 JsonDocument eventMsg;
                 api_buildIRCodeEvent(eventMsg, code);
-                api_sendJsonReply(eventMsg, learningClient);
+                api_sendJsonReply(eventMsg, learningServer ? learningServer->client(learningClientId) : NULL);
                 receiveIRState = false;
                 setLedStateNormal();
             }
+            else
+            {
+                waitTicks = IR_LEARN_POLL_MS / portTICK_PERIOD_MS;
+            }
         }
 #endif
 
+#ifdef BLASTER_IR_POLL_MS
+        // previous polling loop; only for comparing the send latency
+        waitTicks = 0;
+#endif
+
         if (irQueueHandle != NULL)
         {
-            int ret = xQueueReceive(irQueueHandle, &message, 0);
-            // int ret = xQueueReceive(irQueueHandle, &message, portMAX_DELAY);
+            int ret = xQueueReceive(irQueueHandle, &item, waitTicks);
             if (ret == pdPASS)
             {
-                switch (message.action)
+                switch (item.action)
                 {
                 case send:
                 {
-                    // pin indicator was removed from the ir mask.
-                    // TODO: trigger some short flashing once a ir command is sent.
-                    uint32_t ir_pin_mask = 0;
-                    if(message.ir_internal)
+                    // a send item is the first of a chain of linked messages (ir_send_sequence)
+                    uint8_t slot = item.slot;
+                    irSendStarted();
+                    irSendQueuedAt = item.queuedAt;
+                    irSendEmitting = false;
+
+                    ir_send_result_t result = {item.reqId, 200, false, 0, 0, 0, 0};
+                    irRepeatsGranted = 0;
+                    irActiveHold = item.holdId;
+                    if (irActiveHold != 0)
                     {
-                        if(BLASTER_ENABLE_IR_INTERNAL == true)
-                        {
-                            ir_pin_mask |= message.ir_internal << BLASTER_PIN_IR_INTERNAL;    
-                        }
-                        else
-                        {
-                            ESP_LOGD(TAG, "Internal IR channel requested but not available in dock configuration");
-                        }
+                        // the timeout of a hold runs from its first frame, not from the request
+                        irHoldStart(irActiveHold, item.holdTimeoutMs);
                     }
-                    if(message.ir_ext1)
+                    if (item.parallel)
                     {
-                        if(BLASTER_ENABLE_IR_OUT_1 == true)
-                        {
-                            ir_pin_mask |= message.ir_ext1 << BLASTER_PIN_IR_OUT_1;    
-                        }
-                        else
+                        // ir_send_channels: the whole chain at once, released below
+                        result.channels = transmitParallel(slot, result.code);
+                        if (result.channels == 0 && result.code == 200)
                         {
-                            ESP_LOGD(TAG, "External IR channel 1 requested but not available in dock configuration");
+                            result.code = 503;
                         }
                     }
-                    if(message.ir_ext2)
+                    while (!item.parallel && slot != IR_NO_SLOT && !irStopRequested())
                     {
-                        if(BLASTER_ENABLE_IR_OUT_2 == true)
+                        const uint8_t channels = transmitMessage(slot);
+                        if (channels == 0)
                         {
-                            ir_pin_mask |= message.ir_ext2 << BLASTER_PIN_IR_OUT_2;
+                            result.code = 503;
                         }
-                        else
+                        result.channels |= channels;
+
+                        const uint8_t next = irPoolMessage(slot).next;
+                        const uint16_t delayMs = irPoolMessage(slot).delayMs;
+                        irPoolRelease(slot);
+                        slot = next;
+
+                        if (slot != IR_NO_SLOT && delayMs > 0)
                         {
-                            ESP_LOGD(TAG, "External IR channel 2 requested but not available in dock configuration");
+                            waitSequenceDelay(delayMs);
                         }
                     }
-
-                    // TODO: do we need to report back, if we are not sending the command?
-                    // at least log a warning!
-                    if (ir_pin_mask == 0)
+                    // remaining codes of a cancelled sequence
+                    irPoolReleaseChain(slot);
+                    if (irHoldActive(irActiveHold))
                     {
-                        ESP_LOGE(TAG, "IR command could not be sent. All IR channels requested for sending are not available in the dock configuration");
-                        ESP_LOGD(TAG, "Requested channels: internal=%s, out_1=%s, out_2=%s", message.ir_internal?"true ":"false", message.ir_ext1?"true ":"false", message.ir_ext2?"true ":"false");
-                        ESP_LOGD(TAG, "Available channels: internal=%s, out_1=%s, out_2=%s", BLASTER_ENABLE_IR_INTERNAL?"true ":"false", BLASTER_ENABLE_IR_OUT_1?"true ":"false", BLASTER_ENABLE_IR_OUT_2?"true ":"false");
+                        // ended by ir_stop; later keepalives must not find it active
+                        irHoldRelease();
                     }
-                    else
-                    {
-                        irsend.setPinMask(ir_pin_mask);
+                    irActiveHold = 0;
+                    irSendFinished();
 
-                        switch (message.format)
-                        {
-                        case pronto:
-                            sendProntoCode(message);
-                            break;
-                        case hex:
-                            sendHexCode(message);
-                            break;
-                        }
+                    result.endUs = esp_timer_get_time();
+                    // nothing went out if no requested channel is available
+                    result.startUs = irSendEmitting ? irSendStartUs : result.endUs;
+                    result.stopped = irStopRequested();
+                    result.repeatsGranted = irRepeatsGranted;
+                    if (item.wsServer != NULL)
+                    {
+                        reportSendDone(item, result);
                     }
                     break;
                 }
-                case repeat:
-                {
-                    irRepeat += message.repeat;
-                    break;
-                }
                 case learn_start:
                 {
                     receiveIRState = true;
+                    learningServer = item.wsServer;
+                    learningClientId = item.wsClientId;
                     ESP_LOGI(TAG, "Starting IR learning");
                     setLedStateLearn();
                     break;
@@ -238,12 +546,18 @@ void TaskIR(void *pvParameters)
                 case stop:
                 default:
                 {
-                    irRepeat = 0;
+                    irClearStop();
                     break;
                 }
                 }
             }
         }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        else
+        {
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+        }
+#ifdef BLASTER_IR_POLL_MS
+        vTaskDelay(BLASTER_IR_POLL_MS / portTICK_PERIOD_MS);
+#endif
     }
 }
\ No newline at end of file
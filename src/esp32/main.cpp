@@ -18,6 +18,7 @@
 #include <wifi_service.h>
 #include <ir_message.h>
 #include <ir_queue.h>
+#include <ir_store.h>
 
 #include <eth_service.h>
 #include <button_service.h>
@@ -30,6 +31,8 @@
 static const char *TAG = "main";
 
 QueueHandle_t irQueueHandle;
+TaskHandle_t irTaskHandle = NULL;
+TaskHandle_t webTaskHandle = NULL;
 
 extern void setLedStateNetworkWait();
 extern void setLedStateNormal();
@@ -56,6 +59,8 @@ void setup()
     SPIFFSService &fsSrv = SPIFFSService::getInstance();
     fsSrv.init();
 
+    irStoreInit();
+
 
 // Task for controlling the LED is only required if indicator led is available
 #if BLASTER_INDICATOR_MODE != INDICATOR_OFF
@@ -93,8 +98,9 @@ void setup()
     }
     if (wifiSrv.isConnected() || ethSrv.isConnected())
     {
-        // Create the queue which will have <QueueElementSize> number of elements, each of size `message_t` and pass the address to <QueueHandle>.
-        irQueueHandle = xQueueCreate(IR_QUEUE_SIZE, sizeof(ir_message_t));
+        // Create the queue which will have <QueueElementSize> number of elements, each of size `ir_queue_item_t` and pass the address to <QueueHandle>.
+        // Code payloads are kept in the message pool, the queue only carries slot indices.
+        irQueueHandle = xQueueCreate(IR_QUEUE_SIZE, sizeof(ir_queue_item_t));
 
         // Check if the queue was successfully created
         if (irQueueHandle == NULL)
@@ -108,18 +114,16 @@ void setup()
 
 
         // tasks for controlling the ir output via wifi
-        TaskHandle_t *webTaskHandle = NULL;
         taskCreate = xTaskCreatePinnedToCore(
             TaskWeb, "Task Web/Websocket server",
-            16384, NULL, 2, webTaskHandle, 0);
+            BLASTER_WEB_TASK_STACK, NULL, 2, &webTaskHandle, 0);
         if (taskCreate != pdPASS)
         {
             ESP_LOGE(TAG, "Creation of web task failed. Returnvalue: %d.\n", taskCreate);
         }
-        TaskHandle_t *irTaskHandle = NULL;
         taskCreate = xTaskCreatePinnedToCore(
             TaskIR, "Task IR send/receive",
-            32768, NULL, 3 /* highest priority */, irTaskHandle, 1);
+            BLASTER_IR_TASK_STACK, NULL, 3 /* highest priority */, &irTaskHandle, 1);
         if (taskCreate != pdPASS)
         {
             ESP_LOGE(TAG, "Creation of IR task failed. Returnvalue: %d.\n", taskCreate);
@@ -0,0 +1,192 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of the parts of the ESP32 Arduino core the IR service uses.
+// Logging is compiled out, so it is not part of the measurements.
+
+#ifndef FAKE_ARDUINO_H_
+#define FAKE_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <chrono>
+
+typedef bool boolean;
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define LOW 0x0
+#define HIGH 0x1
+
+inline void blasterLogDiscard(const char *, const char *, ...) {}
+
+#define ESP_LOGE(tag, ...) blasterLogDiscard(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) blasterLogDiscard(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) blasterLogDiscard(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) blasterLogDiscard(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) blasterLogDiscard(tag, __VA_ARGS__)
+
+inline unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline unsigned long millis()
+{
+    return micros() / 1000;
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+struct EspClass
+{
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return micros() * 240; }
+};
+static EspClass ESP __attribute__((unused));
+
+// Heap behaviour of the WString of the ESP32 core: up to 11 characters are
+// kept inside the object, longer strings in a buffer of exactly their length.
+class String
+{
+public:
+    String() { init(); }
+    String(const char *text)
+    {
+        init();
+        if (text != NULL)
+        {
+            concat(text, strlen(text));
+        }
+    }
+    String(const String &other)
+    {
+        init();
+        concat(other.c_str(), other.len);
+    }
+    explicit String(int value) { initNumber("%d", value); }
+    explicit String(unsigned int value) { initNumber("%u", value); }
+    explicit String(unsigned char value) { initNumber("%u", value); }
+    explicit String(long value) { initNumber("%ld", value); }
+    explicit String(unsigned long value) { initNumber("%lu", value); }
+    ~String()
+    {
+        if (heap != NULL)
+        {
+            free(heap);
+        }
+    }
+
+    String &operator=(const String &other)
+    {
+        if (this != &other)
+        {
+            len = 0;
+            concat(other.c_str(), other.len);
+        }
+        return *this;
+    }
+
+    const char *c_str() const { return heap != NULL ? heap : sso; }
+    unsigned int length() const { return len; }
+
+    bool concat(const char *text, unsigned int count)
+    {
+        if (!reserve(len + count))
+        {
+            return false;
+        }
+        char *buffer = heap != NULL ? heap : sso;
+        memmove(buffer + len, text, count);
+        len += count;
+        buffer[len] = 0;
+        return true;
+    }
+
+    String &operator+=(const String &other)
+    {
+        concat(other.c_str(), other.len);
+        return *this;
+    }
+    String &operator+=(const char *text)
+    {
+        concat(text, strlen(text));
+        return *this;
+    }
+
+    bool operator==(const char *text) const { return strcmp(c_str(), text) == 0; }
+    bool operator!=(const char *text) const { return !(*this == text); }
+    bool operator==(const String &other) const { return *this == other.c_str(); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+
+private:
+    static const unsigned int SSO_CAPACITY = 11;
+    char sso[SSO_CAPACITY + 1];
+    char *heap;
+    unsigned int capacity;
+    unsigned int len;
+
+    void init()
+    {
+        sso[0] = 0;
+        heap = NULL;
+        capacity = SSO_CAPACITY;
+        len = 0;
+    }
+
+    template <typename T> void initNumber(const char *format, T value)
+    {
+        init();
+        char digits[24];
+        const int count = snprintf(digits, sizeof(digits), format, value);
+        concat(digits, count);
+    }
+
+    bool reserve(unsigned int size)
+    {
+        if (size <= capacity)
+        {
+            return true;
+        }
+        char *buffer = (char *)realloc(heap, size + 1);
+        if (buffer == NULL)
+        {
+            return false;
+        }
+        if (heap == NULL)
+        {
+            memcpy(buffer, sso, len + 1);
+        }
+        heap = buffer;
+        capacity = size;
+        return true;
+    }
+};
+
+inline String operator+(const String &lhs, const String &rhs)
+{
+    String sum(lhs);
+    sum += rhs;
+    return sum;
+}
+
+inline String operator+(const String &lhs, const char *rhs)
+{
+    String sum(lhs);
+    sum += rhs;
+    return sum;
+}
+
+inline String operator+(const char *lhs, const String &rhs)
+{
+    String sum(lhs);
+    sum += rhs;
+    return sum;
+}
+
+#endif
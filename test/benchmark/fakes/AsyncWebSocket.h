@@ -0,0 +1,26 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of ESPAsyncWebServer: requests of the benchmarks come without
+// a websocket client.
+
+#ifndef FAKE_ASYNCWEBSOCKET_H_
+#define FAKE_ASYNCWEBSOCKET_H_
+
+#include <stdint.h>
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient
+{
+public:
+    AsyncWebSocket *server() { return NULL; }
+    uint32_t id() { return 0; }
+};
+
+class AsyncWebSocket
+{
+public:
+    AsyncWebSocketClient *client(uint32_t) { return NULL; }
+};
+
+#endif
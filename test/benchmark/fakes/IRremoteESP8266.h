@@ -0,0 +1,54 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of IRremoteESP8266: the protocol numbers and the constants the
+// IR service uses, with the numbering of the library.
+
+#ifndef FAKE_IRREMOTEESP8266_H_
+#define FAKE_IRREMOTEESP8266_H_
+
+#include <stdint.h>
+
+enum decode_type_t {
+    UNKNOWN = -1,
+    UNUSED = 0,
+    RC5, RC6, NEC, SONY, PANASONIC, JVC, SAMSUNG, WHYNTER, AIWA_RC_T501, LG, SANYO, MITSUBISHI, DISH, SHARP,
+    COOLIX, DAIKIN, DENON, KELVINATOR, SHERWOOD, MITSUBISHI_AC, RCMM, SANYO_LC7461, RC5X, GREE, PRONTO,
+    NEC_LIKE, ARGO, TROTEC, NIKAI, RAW, GLOBALCACHE, TOSHIBA_AC, FUJITSU_AC, MIDEA, MAGIQUEST, LASERTAG,
+    CARRIER_AC, HAIER_AC, MITSUBISHI2, HITACHI_AC, HITACHI_AC1, HITACHI_AC2, GICABLE, HAIER_AC_YRW02,
+    WHIRLPOOL_AC, SAMSUNG_AC, LUTRON, ELECTRA_AC, PANASONIC_AC, PIONEER, LG2, MWM, DAIKIN2, VESTEL_AC, TECO,
+    SAMSUNG36, TCL112AC, LEGOPF, MITSUBISHI_HEAVY_88, MITSUBISHI_HEAVY_152, DAIKIN216, SHARP_AC, GOODWEATHER,
+    INAX, DAIKIN160, NEOCLIMA, DAIKIN176, DAIKIN128, AMCOR, DAIKIN152, MITSUBISHI136, MITSUBISHI112,
+    HITACHI_AC424, SONY_38K, EPSON, SYMPHONY, HITACHI_AC3, DAIKIN64, AIRWELL, DELONGHI_AC, DOSHISHA,
+    MULTIBRACKETS, CARRIER_AC40, CARRIER_AC64, HITACHI_AC344, CORONA_AC, MIDEA24, ZEPEAL, SANYO_AC, VOLTAS,
+    METZ, TRANSCOLD, TECHNIBEL_AC, MIRAGE, ELITESCREENS, PANASONIC_AC32, MILESTAG2, ECOCLIM, XMP, TRUMA,
+    HAIER_AC176, TEKNOPOINT, KELON, TROTEC_3550, SANYO_AC88, BOSE, ARRIS, RHOSS, AIRTON, COOLIX48,
+    HITACHI_AC264, KELON168, HITACHI_AC296, DAIKIN200, HAIER_AC160, CARRIER_AC128, TOTO, CLIMABUTLER, TCL96AC,
+    BOSCH144, SANYO_AC152, DAIKIN312, GORENJE, WOWWEE, CARRIER_AC84, YORK,
+    kLastDecodeType = YORK,
+};
+
+// State of the longest AC protocol, HITACHI_AC424
+const uint16_t kStateSizeMax = 53;
+const uint16_t kNoRepeat = 0;
+const uint8_t kDutyDefault = 50;
+
+#ifndef _IR_ENABLE_DEFAULT_
+#define _IR_ENABLE_DEFAULT_ true
+#endif
+#ifndef SEND_NEC
+#define SEND_NEC _IR_ENABLE_DEFAULT_
+#endif
+#ifndef SEND_SAMSUNG
+#define SEND_SAMSUNG _IR_ENABLE_DEFAULT_
+#endif
+#ifndef SEND_SONY
+#define SEND_SONY _IR_ENABLE_DEFAULT_
+#endif
+#ifndef SEND_RC5
+#define SEND_RC5 _IR_ENABLE_DEFAULT_
+#endif
+#ifndef SEND_RC6
+#define SEND_RC6 _IR_ENABLE_DEFAULT_
+#endif
+
+#endif
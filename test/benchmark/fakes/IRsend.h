@@ -0,0 +1,25 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of IRremoteESP8266: an IRsend that sends nothing.
+
+#ifndef FAKE_IRSEND_H_
+#define FAKE_IRSEND_H_
+
+#include <stdint.h>
+#include "IRremoteESP8266.h"
+
+class IRsend
+{
+public:
+    IRsend(bool, uint16_t) {}
+    void begin() {}
+    void setPinMask(uint32_t) {}
+    void setRepeatCallback(bool (*)()) {}
+    void enableIROut(uint32_t, uint8_t = kDutyDefault) {}
+    uint16_t mark(uint16_t) { return 0; }
+    void space(uint32_t) {}
+    bool send(decode_type_t, uint64_t, uint16_t, uint16_t = kNoRepeat) { return true; }
+    bool send(decode_type_t, const uint8_t *, uint16_t) { return true; }
+};
+
+#endif
@@ -0,0 +1,27 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of IRremoteESP8266: the protocol names, one per decode_type_t.
+
+#ifndef FAKE_IRTEXT_H_
+#define FAKE_IRTEXT_H_
+
+static const char *const kAllProtocolNamesStr =
+    "UNUSED\0" "RC5\0" "RC6\0" "NEC\0" "SONY\0" "PANASONIC\0" "JVC\0" "SAMSUNG\0" "WHYNTER\0" "AIWA_RC_T501\0"
+    "LG\0" "SANYO\0" "MITSUBISHI\0" "DISH\0" "SHARP\0" "COOLIX\0" "DAIKIN\0" "DENON\0" "KELVINATOR\0"
+    "SHERWOOD\0" "MITSUBISHI_AC\0" "RCMM\0" "SANYO_LC7461\0" "RC5X\0" "GREE\0" "PRONTO\0" "NEC_LIKE\0" "ARGO\0"
+    "TROTEC\0" "NIKAI\0" "RAW\0" "GLOBALCACHE\0" "TOSHIBA_AC\0" "FUJITSU_AC\0" "MIDEA\0" "MAGIQUEST\0"
+    "LASERTAG\0" "CARRIER_AC\0" "HAIER_AC\0" "MITSUBISHI2\0" "HITACHI_AC\0" "HITACHI_AC1\0" "HITACHI_AC2\0"
+    "GICABLE\0" "HAIER_AC_YRW02\0" "WHIRLPOOL_AC\0" "SAMSUNG_AC\0" "LUTRON\0" "ELECTRA_AC\0" "PANASONIC_AC\0"
+    "PIONEER\0" "LG2\0" "MWM\0" "DAIKIN2\0" "VESTEL_AC\0" "TECO\0" "SAMSUNG36\0" "TCL112AC\0" "LEGOPF\0"
+    "MITSUBISHI_HEAVY_88\0" "MITSUBISHI_HEAVY_152\0" "DAIKIN216\0" "SHARP_AC\0" "GOODWEATHER\0" "INAX\0"
+    "DAIKIN160\0" "NEOCLIMA\0" "DAIKIN176\0" "DAIKIN128\0" "AMCOR\0" "DAIKIN152\0" "MITSUBISHI136\0"
+    "MITSUBISHI112\0" "HITACHI_AC424\0" "SONY_38K\0" "EPSON\0" "SYMPHONY\0" "HITACHI_AC3\0" "DAIKIN64\0"
+    "AIRWELL\0" "DELONGHI_AC\0" "DOSHISHA\0" "MULTIBRACKETS\0" "CARRIER_AC40\0" "CARRIER_AC64\0"
+    "HITACHI_AC344\0" "CORONA_AC\0" "MIDEA24\0" "ZEPEAL\0" "SANYO_AC\0" "VOLTAS\0" "METZ\0" "TRANSCOLD\0"
+    "TECHNIBEL_AC\0" "MIRAGE\0" "ELITESCREENS\0" "PANASONIC_AC32\0" "MILESTAG2\0" "ECOCLIM\0" "XMP\0" "TRUMA\0"
+    "HAIER_AC176\0" "TEKNOPOINT\0" "KELON\0" "TROTEC_3550\0" "SANYO_AC88\0" "BOSE\0" "ARRIS\0" "RHOSS\0"
+    "AIRTON\0" "COOLIX48\0" "HITACHI_AC264\0" "KELON168\0" "HITACHI_AC296\0" "DAIKIN200\0" "HAIER_AC160\0"
+    "CARRIER_AC128\0" "TOTO\0" "CLIMABUTLER\0" "TCL96AC\0" "BOSCH144\0" "SANYO_AC152\0" "DAIKIN312\0"
+    "GORENJE\0" "WOWWEE\0" "CARRIER_AC84\0" "YORK\0";
+
+#endif
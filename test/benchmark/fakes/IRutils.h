@@ -0,0 +1,46 @@
+// Copyright 2024 Craig Petchell
+
+// Host fake of IRremoteESP8266: the helpers the IR service uses.
+
+#ifndef FAKE_IRUTILS_H_
+#define FAKE_IRUTILS_H_
+
+#include <Arduino.h>
+#include "IRremoteESP8266.h"
+
+// Protocols sent from a state array, as the library lists them
+inline bool hasACState(const decode_type_t protocol)
+{
+    switch (protocol)
+    {
+    case AMCOR: case ARGO: case BOSCH144: case CARRIER_AC84: case CARRIER_AC128: case CORONA_AC: case DAIKIN:
+    case DAIKIN128: case DAIKIN152: case DAIKIN160: case DAIKIN176: case DAIKIN2: case DAIKIN200:
+    case DAIKIN216: case DAIKIN312: case ELECTRA_AC: case FUJITSU_AC: case GREE: case HAIER_AC:
+    case HAIER_AC_YRW02: case HAIER_AC160: case HAIER_AC176: case HITACHI_AC: case HITACHI_AC1:
+    case HITACHI_AC2: case HITACHI_AC3: case HITACHI_AC264: case HITACHI_AC296: case HITACHI_AC344:
+    case HITACHI_AC424: case KELON168: case KELVINATOR: case MIRAGE: case MITSUBISHI_AC: case MITSUBISHI112:
+    case MITSUBISHI136: case MITSUBISHI_HEAVY_88: case MITSUBISHI_HEAVY_152: case MWM: case NEOCLIMA:
+    case PANASONIC_AC: case RHOSS: case SAMSUNG_AC: case SANYO_AC: case SANYO_AC88: case SANYO_AC152:
+    case SHARP_AC: case TCL96AC: case TCL112AC: case TEKNOPOINT: case TOSHIBA_AC: case TROTEC:
+    case TROTEC_3550: case VOLTAS: case WHIRLPOOL_AC: case YORK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline String uint64ToString(uint64_t input, uint8_t base = 10)
+{
+    char digits[65];
+    char *pos = digits + sizeof(digits) - 1;
+    *pos = 0;
+    do
+    {
+        const uint8_t digit = input % base;
+        *--pos = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        input /= base;
+    } while (input > 0);
+    return String(pos);
+}
+
+#endif
@@ -0,0 +1,79 @@
+// Copyright 2024 Craig Petchell
+
+#ifndef FAKE_FREERTOS_QUEUE_H_
+#define FAKE_FREERTOS_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+} fake_queue_t;
+
+typedef fake_queue_t *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    fake_queue_t *queue = (fake_queue_t *)calloc(1, sizeof(fake_queue_t));
+    queue->items = (uint8_t *)malloc(length * itemSize);
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+inline void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->items);
+    free(queue);
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t)
+{
+    if (queue->count == queue->length)
+    {
+        return errQUEUE_FULL;
+    }
+    const UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + tail * queue->itemSize, item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    return xQueueSendToBack(queue, item, wait);
+}
+
+inline BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t)
+{
+    if (queue->count == queue->length)
+    {
+        return errQUEUE_FULL;
+    }
+    queue->head = (queue->head + queue->length - 1) % queue->length;
+    memcpy(queue->items + queue->head * queue->itemSize, item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t)
+{
+    if (queue->count == 0)
+    {
+        return errQUEUE_EMPTY;
+    }
+    memcpy(item, queue->items + queue->head * queue->itemSize, queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+#endif
@@ -0,0 +1,26 @@
+// Copyright 2024 Craig Petchell
+
+#ifndef FAKE_FREERTOS_SEMPHR_H_
+#define FAKE_FREERTOS_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    static int mutex;
+    return &mutex;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t)
+{
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t)
+{
+    return pdTRUE;
+}
+
+#endif
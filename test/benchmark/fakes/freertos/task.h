@@ -0,0 +1,19 @@
+// Copyright 2024 Craig Petchell
+
+#ifndef FAKE_FREERTOS_TASK_H_
+#define FAKE_FREERTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t)
+{
+    return pdPASS;
+}
+
+// The host stack is not painted
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t)
+{
+    return 0;
+}
+
+#endif
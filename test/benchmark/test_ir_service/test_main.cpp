@@ -0,0 +1,345 @@
+// Copyright 2024 Craig Petchell
+
+// Micro-benchmarks of the request side of the IR service: the build steps of
+// ir_service.cpp and queueIR from the request text to the queued message.
+// lib/ir_service is built against the host fakes in test/benchmark/fakes
+// (env native_benchmark).
+//
+// Every case reports one JSON line with the time, the heap allocations and
+// the peak stack per operation; tools/ir_service_benchmark.py collects them
+// and compares them with an earlier run.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <chrono>
+
+#include <ArduinoJson.h>
+#include <ir_service.h>
+#include <ir_queue.h>
+#include <ir_cache.h>
+#include <api_service.h>
+#include <ir_formats.h>
+
+#define BENCHMARK_ITERATIONS 2000
+#define STACK_PAINT_BYTES (64 * 1024)
+#define STACK_PAINT 0xA5
+
+// Set up by main.cpp on the dock
+QueueHandle_t irQueueHandle = NULL;
+TaskHandle_t irTaskHandle = NULL;
+TaskHandle_t webTaskHandle = NULL;
+
+// Build steps of ir_service.cpp
+ir_parse_error buildTimingMessage(const ir_format_handler_t &handler, const char *irCode, ir_message_t &message);
+ir_parse_error buildHexMessage(const char *irCode, ir_message_t &message);
+
+// Response fields as api_service fills them; api_service itself needs the dock.
+void api_fillDefaultResponseFields(JsonDocument &input, JsonDocument &output, int code, boolean reboot)
+{
+    output["type"] = input["type"];
+    if (input.containsKey("id"))
+    {
+        output["req_id"] = input["id"];
+    }
+    if (input.containsKey("command"))
+    {
+        output["msg"] = input["command"];
+    }
+    output["code"] = code;
+    output["reboot"] = reboot;
+}
+
+void api_replyWithError(JsonDocument &request, JsonDocument &response, int errorCode, String errorMsg)
+{
+    api_fillDefaultResponseFields(request, response, errorCode);
+    if (errorMsg != "")
+    {
+        response["error"] = errorMsg;
+    }
+}
+
+// Heap allocations, counted by the wrappers the linker puts around the
+// allocation functions (-Wl,--wrap in platformio.ini). operator new is
+// replaced below, as the one of the C++ runtime is not wrapped.
+static bool countAllocations = false;
+static uint32_t allocations = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations += countAllocations;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations += countAllocations;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations += countAllocations;
+    return __real_realloc(ptr, size);
+}
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(const char *input);
+    void (*reset)(); // prepares the next run, not measured; may be NULL
+    const char *input;
+} benchmark_case_t;
+
+static char longPronto[MAX_IR_CODE_LENGTH * 2];
+static ir_message_t message;
+static uintptr_t paintedBottom = 0;
+
+void setUp(void)
+{
+}
+
+void tearDown(void) {
+    // clean stuff up here
+}
+
+// Builds a pronto code of `pairs` burst pairs that no protocol matches.
+static void buildLongPronto(char *buffer, size_t size, uint16_t pairs)
+{
+    size_t pos = snprintf(buffer, size, "0000 006D %04X 0000", pairs);
+    for (uint16_t i = 0; i < pairs && pos < size; i++)
+    {
+        pos += snprintf(buffer + pos, size - pos, " 0015 %04X", 0x15 + (i % 0x30));
+    }
+}
+
+// Fills the stack below the caller with STACK_PAINT.
+static __attribute__((noinline)) void paintStack()
+{
+    volatile uint8_t area[STACK_PAINT_BYTES];
+    for (size_t i = 0; i < sizeof(area); i++)
+    {
+        area[i] = STACK_PAINT;
+    }
+    paintedBottom = (uintptr_t)area;
+}
+
+// Stack a run takes at its deepest, found like uxTaskGetStackHighWaterMark
+// finds it on the dock: as the painted bytes it overwrote.
+static __attribute__((noinline)) uint32_t measureStack(const benchmark_case_t &bench)
+{
+    const uint8_t *top = (const uint8_t *)__builtin_frame_address(0);
+    paintStack();
+    bench.run(bench.input);
+    const uint8_t *deepest = (const uint8_t *)paintedBottom;
+    while (deepest < top && *deepest == STACK_PAINT)
+    {
+        deepest++;
+    }
+    return top - deepest;
+}
+
+static double elapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Time of reading the clock around a run, taken off every run
+static double clockOverheadNs()
+{
+    double total = 0;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        total += elapsedNs(std::chrono::steady_clock::now());
+    }
+    return total / BENCHMARK_ITERATIONS;
+}
+
+static void runBenchmark(const benchmark_case_t &bench)
+{
+    static const double overheadNs = clockOverheadNs();
+    double totalNs = 0;
+    uint32_t totalAllocations = 0;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        if (bench.reset != NULL)
+        {
+            bench.reset();
+        }
+        allocations = 0;
+        countAllocations = true;
+        const auto start = std::chrono::steady_clock::now();
+        bench.run(bench.input);
+        totalNs += elapsedNs(start) - overheadNs;
+        countAllocations = false;
+        totalAllocations += allocations;
+    }
+    if (bench.reset != NULL)
+    {
+        bench.reset();
+    }
+    const uint32_t stackBytes = measureStack(bench);
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "{\"name\":\"%s\",\"iterations\":%d,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"peak_stack_bytes\":%u}",
+             bench.name, BENCHMARK_ITERATIONS, totalNs / BENCHMARK_ITERATIONS,
+             (double)totalAllocations / BENCHMARK_ITERATIONS, (unsigned)stackBytes);
+    TEST_MESSAGE(msg);
+}
+
+static void runPronto(const char *code)
+{
+    buildTimingMessage(*findIRFormat("pronto"), code, message);
+}
+
+static void runHex(const char *code)
+{
+    buildHexMessage(code, message);
+}
+
+// A request as the web task hands it over, from its text to the queued message
+static void runQueueIR(const char *request)
+{
+    JsonDocument input;
+    JsonDocument output;
+    deserializeJson(input, request);
+    queueIR(input, output);
+}
+
+// Takes the queued sends off the queue as the IR task does
+static void drainQueue()
+{
+    ir_queue_item_t item;
+    while (xQueueReceive(irQueueHandle, &item, 0) == pdTRUE)
+    {
+        irSendStarted();
+        irSendFinished();
+        irPoolReleaseChain(item.slot);
+    }
+}
+
+static void resetCold()
+{
+    drainQueue();
+    irCacheClear();
+}
+
+static const char *NEC_PRONTO =
+    "0000 006D 0022 0002 0156 00AB 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 "
+    "0015 0015 0015 0015 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 "
+    "0015 0040 0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 0015 0015 "
+    "0015 0040 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 0015 0604 "
+    "0156 0056 0015 0E43";
+
+static const char *NEC_HEX = "NEC;0x20DF10EF;32;0";
+
+// 25 byte state
+static const char *AC_HEX = "DAIKIN200;0x11DA1718000491240C38000000B050000000C00000A0100000;200;0";
+
+void benchmark_build_messages(void)
+{
+    const benchmark_case_t cases[] = {
+        {"buildTimingMessage/pronto_nec", runPronto, NULL, NEC_PRONTO},
+        {"buildTimingMessage/pronto_2k", runPronto, NULL, longPronto},
+        {"buildHexMessage/nec", runHex, NULL, NEC_HEX},
+        {"buildHexMessage/ac_200bit", runHex, NULL, AC_HEX},
+    };
+    TEST_ASSERT_EQUAL(parse_ok, buildTimingMessage(*findIRFormat("pronto"), NEC_PRONTO, message));
+    TEST_ASSERT_EQUAL(hex, message.format);
+    TEST_ASSERT_EQUAL(parse_ok, buildTimingMessage(*findIRFormat("pronto"), longPronto, message));
+    TEST_ASSERT_EQUAL(timing, message.format);
+    TEST_ASSERT_EQUAL(parse_ok, buildHexMessage(NEC_HEX, message));
+    TEST_ASSERT_EQUAL(parse_ok, buildHexMessage(AC_HEX, message));
+    TEST_ASSERT_EQUAL(25, message.codeLen);
+
+    for (const benchmark_case_t &bench : cases)
+    {
+        runBenchmark(bench);
+    }
+}
+
+void benchmark_queue_ir(void)
+{
+    static char requests[4][MAX_IR_CODE_LENGTH * 3];
+    const char *codes[4][3] = {
+        {"pronto_nec", "pronto", NEC_PRONTO},
+        {"pronto_2k", "pronto", longPronto},
+        {"hex_nec", "hex", NEC_HEX},
+        {"hex_ac_200bit", "hex", AC_HEX},
+    };
+    static char names[8][48];
+    benchmark_case_t cases[8];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        snprintf(requests[i], sizeof(requests[i]),
+                 "{\"type\":\"dock\",\"command\":\"ir_send\",\"id\":%u,\"format\":\"%s\",\"code\":\"%s\","
+                 "\"int_side\":true,\"repeat\":0}",
+                 i + 1, codes[i][1], codes[i][2]);
+
+        JsonDocument input;
+        JsonDocument output;
+        TEST_ASSERT_FALSE(deserializeJson(input, requests[i]));
+        queueIR(input, output);
+        TEST_ASSERT_EQUAL(200, output["code"].as<int>());
+        TEST_ASSERT_EQUAL(1, irQueuedSends());
+        resetCold();
+
+        // the first send of a code parses it, sending it again takes it from the cache
+        snprintf(names[2 * i], sizeof(names[0]), "queueIR/%s", codes[i][0]);
+        cases[2 * i] = {names[2 * i], runQueueIR, resetCold, requests[i]};
+        snprintf(names[2 * i + 1], sizeof(names[0]), "queueIR/%s_cached", codes[i][0]);
+        cases[2 * i + 1] = {names[2 * i + 1], runQueueIR, drainQueue, requests[i]};
+    }
+
+    for (const benchmark_case_t &bench : cases)
+    {
+        runBenchmark(bench);
+    }
+    resetCold();
+}
+
+int main()
+{
+    irQueueHandle = xQueueCreate(IR_QUEUE_SIZE, sizeof(ir_queue_item_t));
+    // about 2 KB, the longest code a request may carry
+    buildLongPronto(longPronto, sizeof(longPronto), 198);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(benchmark_build_messages);
+    RUN_TEST(benchmark_queue_ir);
+
+    return UNITY_END();
+}
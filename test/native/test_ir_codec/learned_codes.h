@@ -0,0 +1,50 @@
+// Copyright 2024 Craig Petchell
+
+// Codes as a receiver learns them, for the size benchmark of the binary
+// encoding. Unlike the generated codes of test_main.cpp, their durations vary
+// from burst to burst, so they show what the encoding makes of learned codes.
+//
+// The raw capture is the one IRremoteESP8266 prints with its IRsendDemo
+// example, recorded with IRrecvDumpV2. The pronto codes are the first frames
+// of the protocol codes of test_main.cpp as a receiver module reports them:
+// marks about 48 us longer and spaces shorter, +-24 us of noise rounded to the
+// 2 us tick of IRrecv, the gap cut at the 15 ms receive timeout and the
+// carrier measured a little off. Captures of further remotes can be added here.
+
+#ifndef LEARNED_CODES_H_
+#define LEARNED_CODES_H_
+
+typedef struct {
+    const char *name;
+    const char *format;
+    const char *code;
+} learned_code_t;
+
+static const learned_code_t LEARNED_CODES[] = {
+    {"IRsendDemo", "raw",
+     "9000,4500,650,550,650,1650,600,550,650,550,600,1650,650,550,600,1650,650,1650,650,1650,600,550,650,1650,650,"
+     "1650,650,550,600,1650,650,1650,650,550,650,550,650,1650,650,550,650,550,650,550,600,550,650,550,650,550,650,"
+     "1650,600,550,650,1650,650,1650,650,1650,650,1650,650,1650,650,1650,600"},
+    {"NEC", "pronto",
+     "0000 006C 0022 0000 015C 00AB 0016 0013 0016 0013 0017 003E 0017 0014 0016 0013 0016 0013 0016 0013 0016 0013 "
+     "0017 003E 0018 003F 0016 0012 0018 003F 0017 003F 0017 003F 0017 003F 0017 003E 0016 0013 0017 0014 0018 0013 "
+     "0018 003F 0018 0014 0016 0014 0016 0013 0018 0013 0016 003F 0017 003F 0017 003E 0017 0013 0016 003E 0017 003E "
+     "0017 003F 0017 0040 0017 0240"},
+    {"SONY", "pronto",
+     "0000 0068 000D 0000 0060 0015 0031 0015 0019 0016 0031 0017 0019 0015 0031 0015 001A 0016 0019 0016 0031 0017 "
+     "001A 0016 001B 0015 001A 0015 001A 0256"},
+    {"RC5", "pronto",
+     "0000 0074 000C 0000 0021 001F 0041 001E 0022 001D 0021 001E 0022 001D 0022 001F 0022 001E 0021 001D 0021 003D "
+     "0021 001F 0042 001E 0022 0218"},
+    {"RC6", "pronto",
+     "0000 0073 0015 0000 0061 001E 0012 001E 0013 000E 0012 000D 0011 001D 0021 000E 0012 000F 0011 000F 0012 000F "
+     "0011 000F 0011 000E 0012 000F 0013 000E 0012 000F 0011 000E 0012 000F 0012 000F 0021 000D 0012 001F 0012 000E "
+     "0011 021D"},
+    {"SAMSUNG", "pronto",
+     "0000 006C 0022 0000 00AE 00A9 0016 003E 0016 003E 0018 003F 0017 0013 0017 0014 0016 0012 0018 0013 0016 0013 "
+     "0017 003E 0017 003E 0018 003E 0017 0013 0017 0014 0016 0013 0016 0013 0017 0014 0017 0014 0016 003E 0017 0014 "
+     "0017 0013 0017 0013 0017 0013 0017 0014 0017 0014 0018 003F 0016 0014 0017 003E 0016 003F 0017 003E 0016 003E "
+     "0016 003F 0017 003F 0018 0240"},
+};
+
+#endif
@@ -0,0 +1,1132 @@
+// Copyright 2024 Craig Petchell
+
+// Native tests for the hardware independent IR code parsers.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <alloca.h>
+#include <chrono>
+
+#include <ir_pronto.h>
+#include <ir_hex.h>
+#include <ir_uccode.h>
+#include <ir_fingerprint.h>
+#include <ir_slot_allocator.h>
+#include <ir_timeline.h>
+#include <ir_repeat_budget.h>
+#include <ir_timing.h>
+#include <ir_recognizer.h>
+#include <ir_formats.h>
+#include <ir_binary.h>
+#include <ir_jitter.h>
+#include <ir_seqlock.h>
+#include <ir_capture.h>
+#include <ir_protocol_index.h>
+#include <ir_code_log.h>
+
+#include "learned_codes.h"
+
+#define MAX_WORDS 1024
+
+static const char *NEC_PRONTO =
+    "0000 006D 0022 0002 0156 00AB 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 "
+    "0015 0015 0015 0015 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 "
+    "0015 0040 0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 0015 0015 "
+    "0015 0040 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 0015 0604 "
+    "0156 0056 0015 0E43";
+
+// Sony power, 12 bits
+static const char *SONY_PRONTO =
+    "0000 0067 0000 000D 0060 0018 0030 0018 0018 0018 0030 0018 0018 0018 0030 0018 "
+    "0018 0018 0018 0018 0030 0018 0018 0018 0018 0018 0018 0018 0018 03F6";
+
+// RC5 address 0, command 12
+static const char *RC5_PRONTO =
+    "0000 0073 0000 000C 0020 0020 0040 0020 0020 0020 0020 0020 0020 0020 0020 0020 "
+    "0020 0020 0020 0020 0020 0040 0020 0020 0040 0020 0020 0A20";
+
+// RC6 mode 0, address 0, command 12, frame in both sections
+static const char *RC6_PRONTO =
+    "0000 0073 0015 0015 0060 0020 0010 0020 0010 0010 0010 0010 0010 0020 0020 0010 "
+    "0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 "
+    "0010 0010 0010 0010 0010 0010 0020 0010 0010 0020 0010 0010 0010 0A00 "
+    "0060 0020 0010 0020 0010 0010 0010 0010 0010 0020 0020 0010 0010 0010 0010 0010 "
+    "0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 "
+    "0010 0010 0020 0010 0010 0020 0010 0010 0010 0A00";
+
+// Samsung TV power
+static const char *SAMSUNG_PRONTO =
+    "0000 006D 0022 0000 00AA 00AA 0015 0040 0015 0040 0015 0040 0015 0015 0015 0015 "
+    "0015 0015 0015 0015 0015 0015 0015 0040 0015 0040 0015 0040 0015 0015 0015 0015 "
+    "0015 0015 0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 "
+    "0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 "
+    "0015 0040 0015 0040 0015 0040 0015 0700";
+
+// Protocol names as IRremoteESP8266 keeps them, one per decode_type_t
+static const char *PROTOCOL_NAMES =
+    "UNUSED\0" "RC5\0" "RC6\0" "NEC\0" "SONY\0" "PANASONIC\0" "JVC\0" "SAMSUNG\0" "WHYNTER\0"
+    "AIWA_RC_T501\0" "LG\0" "SANYO\0" "MITSUBISHI\0" "DISH\0" "SHARP\0" "COOLIX\0" "DAIKIN\0"
+    "DENON\0" "KELVINATOR\0" "SHERWOOD\0" "MITSUBISHI_AC\0" "RCMM\0" "SANYO_LC7461\0" "RC5X\0"
+    "GREE\0" "PRONTO\0" "NEC_LIKE\0" "ARGO\0" "TROTEC\0" "NIKAI\0" "RAW\0" "GLOBALCACHE\0"
+    "TOSHIBA_AC\0" "FUJITSU_AC\0" "MIDEA\0" "MAGIQUEST\0" "LASERTAG\0" "CARRIER_AC\0" "HAIER_AC\0"
+    "MITSUBISHI2\0" "HITACHI_AC\0" "HITACHI_AC1\0" "HITACHI_AC2\0" "GICABLE\0" "HAIER_AC_YRW02\0"
+    "WHIRLPOOL_AC\0" "SAMSUNG_AC\0" "LUTRON\0" "ELECTRA_AC\0" "PANASONIC_AC\0" "PIONEER\0" "LG2\0"
+    "MWM\0" "DAIKIN2\0" "VESTEL_AC\0" "TECO\0" "SAMSUNG36\0" "TCL112AC\0" "LEGOPF\0"
+    "MITSUBISHI_HEAVY_88\0" "MITSUBISHI_HEAVY_152\0" "DAIKIN216\0" "SHARP_AC\0" "GOODWEATHER\0"
+    "INAX\0" "DAIKIN160\0" "NEOCLIMA\0" "DAIKIN176\0" "DAIKIN128\0" "AMCOR\0" "DAIKIN152\0"
+    "MITSUBISHI136\0" "MITSUBISHI112\0" "HITACHI_AC424\0" "SONY_38K\0" "EPSON\0" "SYMPHONY\0"
+    "HITACHI_AC3\0" "DAIKIN64\0" "AIRWELL\0" "DELONGHI_AC\0" "DOSHISHA\0" "MULTIBRACKETS\0"
+    "CARRIER_AC40\0" "CARRIER_AC64\0" "HITACHI_AC344\0" "CORONA_AC\0" "MIDEA24\0" "ZEPEAL\0"
+    "SANYO_AC\0" "VOLTAS\0" "METZ\0" "TRANSCOLD\0" "TECHNIBEL_AC\0" "MIRAGE\0" "ELITESCREENS\0"
+    "PANASONIC_AC32\0" "MILESTAG2\0" "ECOCLIM\0" "XMP\0" "TRUMA\0" "HAIER_AC176\0" "TEKNOPOINT\0"
+    "KELON\0" "TROTEC_3550\0" "SANYO_AC88\0" "BOSE\0" "ARRIS\0" "RHOSS\0" "AIRTON\0" "COOLIX48\0"
+    "HITACHI_AC264\0" "KELON168\0" "HITACHI_AC296\0" "DAIKIN200\0" "HAIER_AC160\0" "CARRIER_AC128\0"
+    "TOTO\0" "CLIMABUTLER\0" "TCL96AC\0" "BOSCH144\0" "SANYO_AC152\0" "DAIKIN312\0" "GORENJE\0"
+    "WOWWEE\0" "CARRIER_AC84\0" "YORK\0";
+
+static uint16_t words[MAX_WORDS];
+static uint32_t durations[MAX_WORDS];
+
+void setUp(void)
+{
+    memset(words, 0, sizeof(words));
+}
+
+void tearDown(void) {
+    // clean stuff up here
+}
+
+// Builds a pronto code of `pairs` burst pairs with the given delimiter.
+static void buildLongPronto(char *buffer, size_t size, uint16_t pairs, char delimiter)
+{
+    size_t pos = snprintf(buffer, size, "0000%c006D%c%04X%c0000", delimiter, delimiter, pairs, delimiter);
+    for (uint16_t i = 0; i < pairs && pos < size; i++)
+    {
+        pos += snprintf(buffer + pos, size - pos, "%c0015%c%04X", delimiter, delimiter, 0x15 + (i % 0x30));
+    }
+}
+
+// Implementation replaced by parseProntoCode. Kept as reference for the benchmark.
+static uint16_t legacyBuildPronto(const char *irCode, uint16_t *code16)
+{
+    const int strCodeLen = strlen(irCode);
+    char *workingCode = (char *)alloca(strCodeLen + 1);
+    char *workingPtr;
+    uint16_t codeLen = (strCodeLen + 1) / 5;
+    uint16_t offset = 0;
+
+    strcpy(workingCode, irCode);
+    char delimiter[2] = {workingCode[4], 0};
+
+    char *hexCode = strtok_r(workingCode, delimiter, &workingPtr);
+    while (hexCode)
+    {
+        code16[offset++] = strtoul(hexCode, NULL, 16);
+        hexCode = strtok_r(NULL, delimiter, &workingPtr);
+    }
+    return codeLen;
+}
+
+// IRremoteESP8266's strToDecodeType, replaced by IrProtocolIndex. Kept as reference for the benchmark.
+static int16_t legacyStrToDecodeType(const char *str)
+{
+    const char *ptr = PROTOCOL_NAMES;
+    uint16_t length = strlen(ptr);
+    for (int16_t i = 0; length; i++)
+    {
+        if (!strcasecmp(str, ptr))
+        {
+            return i;
+        }
+        ptr += length + 1;
+        length = strlen(ptr);
+    }
+    return -1;
+}
+
+void test_pronto_nec(void)
+{
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(parse_ok, parseProntoCode(NEC_PRONTO, words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(76, count);
+    TEST_ASSERT_EQUAL_HEX16(0x006D, words[PRONTO_FREQ_OFFSET]);
+    TEST_ASSERT_EQUAL_HEX16(0x0156, words[4]);
+    TEST_ASSERT_EQUAL_HEX16(0x0E43, words[75]);
+}
+
+void test_pronto_mixed_delimiters(void)
+{
+    uint16_t count = 0;
+    const char *code = "0000,006d 0001, 0000\t00aB ,0001\r\n";
+    TEST_ASSERT_EQUAL(parse_ok, parseProntoCode(code, words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(6, count);
+    TEST_ASSERT_EQUAL_HEX16(0x00AB, words[4]);
+    TEST_ASSERT_EQUAL_HEX16(0x0001, words[5]);
+}
+
+void test_pronto_errors(void)
+{
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(parse_empty, parseProntoCode("", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_empty, parseProntoCode(" ,, ", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_invalid_char, parseProntoCode("0000 006D 000G 0000", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_word_overflow, parseProntoCode("0000 006D0 0001 0000 0001 0001", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_header_too_short, parseProntoCode("0000 006D 0001", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_unsupported_type, parseProntoCode("0100 006D 0001 0000 0001 0001", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_invalid_frequency, parseProntoCode("0000 0000 0001 0000 0001 0001", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_length_mismatch, parseProntoCode("0000 006D 0002 0000 0001 0001", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_length_mismatch, parseProntoCode("0000 006D 0000 0000", words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(parse_too_long, parseProntoCode(NEC_PRONTO, words, 10, count));
+}
+
+void test_pronto_long_code(void)
+{
+    static char code[4096];
+    uint16_t count = 0;
+    buildLongPronto(code, sizeof(code), 200, ',');
+    TEST_ASSERT_EQUAL(parse_ok, parseProntoCode(code, words, MAX_WORDS, count));
+    TEST_ASSERT_EQUAL(404, count);
+}
+
+void test_uccode_fields(void)
+{
+    uc_code_t uc;
+    TEST_ASSERT_EQUAL(parse_ok, parseUCCode("NEC;0x20DF10EF;32;0", 424, uc));
+    TEST_ASSERT_EQUAL_STRING("NEC", uc.protocol);
+    TEST_ASSERT_EQUAL(10, uc.codeLen);
+    TEST_ASSERT_EQUAL(0, strncmp("0x20DF10EF", uc.code, uc.codeLen));
+    TEST_ASSERT_EQUAL(32, uc.bits);
+    TEST_ASSERT_EQUAL(0, uc.repeats);
+
+    TEST_ASSERT_EQUAL(parse_empty, parseUCCode("", 424, uc));
+    TEST_ASSERT_EQUAL(parse_missing_field, parseUCCode("NEC;0x20DF10EF;32", 424, uc));
+    TEST_ASSERT_EQUAL(parse_missing_field, parseUCCode("NEC;0x20DF10EF;32;0;1", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_protocol, parseUCCode(";0x20DF10EF;32;0", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_code, parseUCCode("NEC;;32;0", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_bits, parseUCCode("NEC;0x20DF10EF;0;0", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_bits, parseUCCode("NEC;0x20DF10EF;3x;0", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_bits, parseUCCode("NEC;0x20DF10EF;425;0", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_repeat, parseUCCode("NEC;0x20DF10EF;32;21", 424, uc));
+    TEST_ASSERT_EQUAL(parse_invalid_repeat, parseUCCode("NEC;0x20DF10EF;32;", 424, uc));
+
+    char text[20];
+    TEST_ASSERT_TRUE(formatUCCode("NEC", "0x20DF10EF", 32, 0, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("NEC;0x20DF10EF;32;0", text);
+    TEST_ASSERT_FALSE(formatUCCode("SAMSUNG", "0xE0E040BF", 32, 0, text, sizeof(text)));
+}
+
+void test_hex_value(void)
+{
+    uint64_t value = 0;
+    TEST_ASSERT_EQUAL(parse_ok, decodeHexValue("0x20DF10EF", 10, value));
+    TEST_ASSERT_EQUAL_HEX64(0x20DF10EFULL, value);
+    TEST_ASSERT_EQUAL(parse_ok, decodeHexValue("fFfFfFfFfFfFfFfF", 16, value));
+    TEST_ASSERT_EQUAL_HEX64(0xFFFFFFFFFFFFFFFFULL, value);
+    TEST_ASSERT_EQUAL(parse_code_overflow, decodeHexValue("10000000000000000", 17, value));
+    TEST_ASSERT_EQUAL(parse_invalid_code, decodeHexValue("0x", 2, value));
+    TEST_ASSERT_EQUAL(parse_invalid_code, decodeHexValue("12G4", 4, value));
+}
+
+void test_hex_state(void)
+{
+    uint8_t state[8];
+    const uint8_t expectedShort[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xBC, 0xDE};
+    TEST_ASSERT_EQUAL(parse_ok, decodeHexState("0xABCDE", 7, state, sizeof(state)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectedShort, state, sizeof(state));
+
+    // 200 bit AC state spanning several 64 bit chunks
+    const char *ac = "C4D36480000024C0E01BB000000000000000000000000080";
+    uint8_t acState[25];
+    TEST_ASSERT_EQUAL(parse_ok, decodeHexState(ac, strlen(ac), acState, sizeof(acState)));
+    TEST_ASSERT_EQUAL_HEX8(0x00, acState[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xC4, acState[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x24, acState[7]);
+    TEST_ASSERT_EQUAL_HEX8(0xB0, acState[11]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, acState[24]);
+
+    TEST_ASSERT_EQUAL(parse_code_overflow, decodeHexState("0x123456789", 11, state, 4));
+    TEST_ASSERT_EQUAL(parse_invalid_code, decodeHexState("0x12 4", 6, state, 4));
+}
+
+void test_fingerprint_normalization(void)
+{
+    const uint64_t reference = irCodeFingerprint("pronto", "0000 006D 0001 0000 00AB 0001");
+    TEST_ASSERT_EQUAL_HEX64(reference, irCodeFingerprint("pronto", " 0000,006d, 0001 0000\t00ab 0001\r\n"));
+    TEST_ASSERT_EQUAL_HEX64(reference, irCodeFingerprint("PRONTO", "0000 006D 0001 0000 00AB 0001"));
+    TEST_ASSERT_TRUE(reference != irCodeFingerprint("pronto", "0000 006D 0001 0000 00AB 0002"));
+    TEST_ASSERT_TRUE(reference != irCodeFingerprint("hex", "0000 006D 0001 0000 00AB 0001"));
+    TEST_ASSERT_TRUE(irCodeFingerprint("ab", "c") != irCodeFingerprint("a", "bc"));
+    TEST_ASSERT_TRUE(irCodeFingerprint(NULL, NULL) != 0);
+    // base64 is case sensitive
+    TEST_ASSERT_TRUE(irCodeFingerprint("broadlink", "JgAGAEkS") != irCodeFingerprint("broadlink", "jgagaeks"));
+}
+
+void test_slot_allocator(void)
+{
+    IrSlotAllocator allocator(3);
+    TEST_ASSERT_EQUAL(3, allocator.available());
+
+    const uint8_t a = allocator.acquire();
+    const uint8_t b = allocator.acquire();
+    const uint8_t c = allocator.acquire();
+    TEST_ASSERT_TRUE(a != b && b != c && a != c);
+    TEST_ASSERT_TRUE(a < 3 && b < 3 && c < 3);
+    TEST_ASSERT_EQUAL(IR_NO_SLOT, allocator.acquire());
+    TEST_ASSERT_EQUAL(0, allocator.available());
+
+    allocator.release(b);
+    TEST_ASSERT_EQUAL(1, allocator.available());
+    TEST_ASSERT_EQUAL(b, allocator.acquire());
+
+    // releasing an invalid slot must not corrupt the pool
+    allocator.release(IR_NO_SLOT);
+    TEST_ASSERT_EQUAL(0, allocator.available());
+}
+
+void test_repeat_budget(void)
+{
+    IrRepeatBudget budget;
+    TEST_ASSERT_FALSE(budget.take());
+    TEST_ASSERT_FALSE(budget.add(0, 1));
+
+    const uint16_t ticket = budget.open(2);
+    TEST_ASSERT_TRUE(budget.add(ticket, 3));
+    TEST_ASSERT_EQUAL(5, budget.remaining());
+    TEST_ASSERT_TRUE(budget.take());
+    TEST_ASSERT_EQUAL(4, budget.takeAll());
+    TEST_ASSERT_TRUE(budget.add(ticket, 1));
+    TEST_ASSERT_EQUAL(1, budget.close());
+
+    // a closed budget refuses repeats, so the requester knows they were not sent
+    TEST_ASSERT_FALSE(budget.add(ticket, 1));
+    TEST_ASSERT_FALSE(budget.take());
+
+    // a stale ticket cannot add to the next send
+    const uint16_t next = budget.open(0);
+    TEST_ASSERT_TRUE(next != ticket);
+    TEST_ASSERT_FALSE(budget.add(ticket, 1));
+    TEST_ASSERT_TRUE(budget.add(next, 0xFFFF));
+    TEST_ASSERT_EQUAL(IR_MAX_REPEAT_BUDGET, budget.remaining());
+}
+
+void test_repeat_budget_late_add(void)
+{
+    IrRepeatBudget budget;
+    const uint16_t ticket = budget.open(1);
+    TEST_ASSERT_TRUE(budget.take());
+
+    // the take that finds no repeat left closes the budget; a repeat added
+    // after the last frame is refused, so the requester queues a new send
+    TEST_ASSERT_FALSE(budget.take());
+    TEST_ASSERT_FALSE(budget.add(ticket, 2));
+    TEST_ASSERT_EQUAL(0, budget.remaining());
+    TEST_ASSERT_EQUAL(0, budget.close());
+
+    // added before that take, the repeat is sent
+    const uint16_t next = budget.open(0);
+    TEST_ASSERT_TRUE(budget.add(next, 1));
+    TEST_ASSERT_TRUE(budget.take());
+    TEST_ASSERT_FALSE(budget.take());
+}
+
+// Parses a code of a timing format into `durations`
+static ir_raw_code_t parseTimingCode(const char *format, const char *code)
+{
+    ir_raw_code_t raw = {0, durations, 0, 0, MAX_WORDS};
+    const ir_format_handler_t *handler = findIRFormat(format);
+    TEST_ASSERT_NOT_NULL(handler);
+    TEST_ASSERT_EQUAL(parse_ok, handler->parse(code, raw));
+    return raw;
+}
+
+static ir_parse_error parseTimingError(const char *format, const char *code)
+{
+    ir_raw_code_t raw = {0, durations, 0, 0, MAX_WORDS};
+    return findIRFormat(format)->parse(code, raw);
+}
+
+void test_pronto_timings(void)
+{
+    const ir_raw_code_t raw = parseTimingCode("pronto", NEC_PRONTO);
+    TEST_ASSERT_UINT32_WITHIN(10, 38029, raw.carrierHz);
+    TEST_ASSERT_EQUAL(68 + 4, raw.count);
+    TEST_ASSERT_EQUAL(68, raw.repeatStart);
+
+    uint16_t encoded[128];
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, 128, layout));
+    TEST_ASSERT_EQUAL(raw.carrierHz, layout.carrierHz);
+    TEST_ASSERT_EQUAL(1, layout.loopCount - layout.repeatLoop);
+    // runs of equal bits are stored once
+    TEST_ASSERT_TRUE(layout.length < 68 + 4 + 2);
+    // the 96ms gap after the repeat frame is split
+    TEST_ASSERT_EQUAL(IR_TIMING_MAX_US, encoded[layout.length - 3]);
+    TEST_ASSERT_EQUAL(0, encoded[layout.length - 2]);
+    TEST_ASSERT_EQUAL(parse_too_long, encodeTimings(raw, encoded, 60, layout));
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, 128, layout));
+
+    uint32_t timings[128];
+    // once section plus two repeat frames
+    TEST_ASSERT_EQUAL(68 + 2 * 4, expandTimings(encoded, layout, 2, timings, 128));
+    TEST_ASSERT_UINT32_WITHIN(1, 8993, timings[0]);
+    TEST_ASSERT_UINT32_WITHIN(1, 4497, timings[1]);
+    TEST_ASSERT_UINT32_WITHIN(1, 8993, timings[68]);
+    TEST_ASSERT_UINT32_WITHIN(1, 2261, timings[69]);
+    TEST_ASSERT_UINT32_WITHIN(1, 96005, timings[71]);
+    TEST_ASSERT_EQUAL(0, expandTimings(encoded, layout, 2, timings, 70));
+
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(parse_ok, parseProntoCode(NEC_PRONTO, words, MAX_WORDS, count));
+    // longest burst a pronto word can describe, within 0.01%
+    TEST_ASSERT_UINT32_WITHIN(200, 1723317, prontoBurstUs(0xFFFF, prontoPeriodQ16(words)));
+
+    TEST_ASSERT_TRUE(carriersCompatible(38029, 38400));
+    TEST_ASSERT_FALSE(carriersCompatible(38029, 36000));
+}
+
+void test_timing_loops(void)
+{
+    // one frame sent three times in the once section, no repeat section
+    const uint32_t frame[] = {2600, 1300, 260, 780, 260, 260, 260, 780, 260, 260, 260, 18200};
+    for (uint16_t i = 0; i < 3 * 12; i++)
+    {
+        // learned codes jitter
+        durations[i] = frame[i % 12] + (i / 12 == 1 && frame[i % 12] > 260 ? 20 : 0);
+    }
+    const ir_raw_code_t raw = {38000, durations, 36, 36, MAX_WORDS};
+
+    uint16_t encoded[64];
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, 64, layout));
+    TEST_ASSERT_EQUAL(1, layout.loopCount);
+    TEST_ASSERT_EQUAL(1, layout.repeatLoop);
+    TEST_ASSERT_EQUAL(12, layout.length);
+    TEST_ASSERT_EQUAL(0, layout.loops[0].start);
+    TEST_ASSERT_EQUAL(12, layout.loops[0].length);
+    TEST_ASSERT_EQUAL(3, layout.loops[0].count);
+
+    uint32_t timings[64];
+    TEST_ASSERT_EQUAL(36, expandTimings(encoded, layout, 0, timings, 64));
+    for (uint16_t i = 0; i < 36; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(frame[i % 12], timings[i]);
+    }
+    TEST_ASSERT_EQUAL(0, expandTimings(encoded, layout, 0, timings, 30));
+}
+
+static void assertRecognized(const ir_raw_code_t &raw, const char *protocol, uint64_t value, uint16_t bits)
+{
+    ir_native_code_t native;
+    TEST_ASSERT_TRUE(recognizeIRCode(raw, native));
+    TEST_ASSERT_EQUAL_STRING(protocol, native.protocol);
+    TEST_ASSERT_EQUAL_HEX64(value, native.value);
+    TEST_ASSERT_EQUAL(bits, native.bits);
+}
+
+void test_recognize_codes(void)
+{
+    assertRecognized(parseTimingCode("pronto", NEC_PRONTO), "NEC", 0x20DF10EF, 32);
+    assertRecognized(parseTimingCode("pronto", SONY_PRONTO), "SONY", 0xA90, 12);
+    assertRecognized(parseTimingCode("pronto", RC5_PRONTO), "RC5", 0x00C, 12);
+    assertRecognized(parseTimingCode("pronto", RC6_PRONTO), "RC6", 0x0000C, 20);
+    assertRecognized(parseTimingCode("pronto", SAMSUNG_PRONTO), "SAMSUNG", 0xE0E040BF, 32);
+
+    ir_native_code_t native;
+    ir_raw_code_t raw = parseTimingCode("pronto", NEC_PRONTO);
+    // a carrier no NEC remote uses
+    raw.carrierHz = 57600;
+    TEST_ASSERT_FALSE(recognizeIRCode(raw, native));
+    raw.carrierHz = 38000;
+    // a bit of neither length
+    durations[3] = 1100;
+    TEST_ASSERT_FALSE(recognizeIRCode(raw, native));
+    durations[3] = 560;
+    // a repeat section that is no NEC repeat frame
+    durations[69] = 4500;
+    TEST_ASSERT_FALSE(recognizeIRCode(raw, native));
+}
+
+void test_timing_formats(void)
+{
+    ir_raw_code_t raw = parseTimingCode("raw", "36000; 889 889,1778\n");
+    TEST_ASSERT_EQUAL(36000, raw.carrierHz);
+    // ends with a mark, so a gap is added
+    TEST_ASSERT_EQUAL(4, raw.count);
+    TEST_ASSERT_EQUAL(0, raw.repeatStart);
+    TEST_ASSERT_EQUAL_UINT32(1778, durations[2]);
+    TEST_ASSERT_EQUAL_UINT32(IR_RAW_TRAILING_GAP_US, durations[3]);
+    TEST_ASSERT_EQUAL(IR_RAW_DEFAULT_CARRIER_HZ, parseTimingCode("raw", "9000,4500").carrierHz);
+
+    raw = parseTimingCode("globalcache", "sendir,1:1,1,40000,1,3,96,24,48,24,24,960");
+    TEST_ASSERT_EQUAL(40000, raw.carrierHz);
+    TEST_ASSERT_EQUAL(6, raw.count);
+    TEST_ASSERT_EQUAL(2, raw.repeatStart);
+    TEST_ASSERT_EQUAL_UINT32(2400, durations[0]);
+    TEST_ASSERT_EQUAL_UINT32(1200, durations[2]);
+    TEST_ASSERT_EQUAL_UINT32(24000, durations[5]);
+
+    // 73, 18, 36 and 729 ticks of 32.84us
+    raw = parseTimingCode("broadlink", "JgAGAEkSJAAC2Q==");
+    TEST_ASSERT_EQUAL(IR_RAW_DEFAULT_CARRIER_HZ, raw.carrierHz);
+    TEST_ASSERT_EQUAL(4, raw.count);
+    TEST_ASSERT_EQUAL_UINT32(2397, durations[0]);
+    TEST_ASSERT_EQUAL_UINT32(591, durations[1]);
+    TEST_ASSERT_EQUAL_UINT32(1182, durations[2]);
+    TEST_ASSERT_EQUAL_UINT32(23938, durations[3]);
+
+    TEST_ASSERT_NULL(findIRFormat("hex"));
+    TEST_ASSERT_NULL(findIRFormat(NULL));
+    TEST_ASSERT_EQUAL(parse_invalid_duration, parseTimingError("raw", "9000,0"));
+    TEST_ASSERT_EQUAL(parse_invalid_char, parseTimingError("raw", "9000,x"));
+    TEST_ASSERT_EQUAL(parse_invalid_header, parseTimingError("globalcache", "sendirx,1:1,1,40000,1,1,96,24"));
+    // the repeat section has to start with a mark
+    TEST_ASSERT_EQUAL(parse_invalid_duration, parseTimingError("globalcache", "sendir,1:1,1,40000,1,2,96,24,48,24"));
+    TEST_ASSERT_EQUAL(parse_length_mismatch, parseTimingError("globalcache", "sendir,1:1,1,40000,1,1,96,24,48"));
+    // an RF packet
+    TEST_ASSERT_EQUAL(parse_invalid_header, parseTimingError("broadlink", "sgAGAEkSJAAC2Q=="));
+    TEST_ASSERT_EQUAL(parse_length_mismatch, parseTimingError("broadlink", "JgAGAEkSJA=="));
+    TEST_ASSERT_EQUAL(parse_invalid_char, parseTimingError("broadlink", "JgAGAEkS*AAC2Q=="));
+}
+
+// Every format writes the code and parses it back to the same timings, within
+// the resolution of the format, and the result is still recognized.
+void test_format_round_trip(void)
+{
+    static uint32_t reference[MAX_WORDS];
+    static char text[4096];
+    const ir_raw_code_t nec = parseTimingCode("pronto", NEC_PRONTO);
+    memcpy(reference, durations, nec.count * sizeof(uint32_t));
+    // raw and broadlink have no repeat section, so only the first frame
+    const ir_raw_code_t frame = {nec.carrierHz, reference, nec.repeatStart, nec.repeatStart, MAX_WORDS};
+
+    const char *formats[] = {"pronto", "raw", "globalcache", "broadlink", "binary"};
+    for (const char *format : formats)
+    {
+        TEST_ASSERT_TRUE_MESSAGE(findIRFormat(format)->format(frame, text, sizeof(text)), format);
+        const ir_raw_code_t raw = parseTimingCode(format, text);
+        TEST_ASSERT_EQUAL_MESSAGE(frame.count, raw.count, format);
+        for (uint16_t i = 0; i < raw.count; i++)
+        {
+            TEST_ASSERT_UINT32_WITHIN_MESSAGE(20, reference[i], durations[i], format);
+        }
+        assertRecognized(raw, "NEC", 0x20DF10EF, 32);
+
+        // too small a buffer fails instead of truncating the code
+        TEST_ASSERT_FALSE(findIRFormat(format)->format(frame, text, 40));
+    }
+
+    // formats with repeat section keep it
+    const ir_raw_code_t original = {nec.carrierHz, reference, nec.count, nec.repeatStart, MAX_WORDS};
+    findIRFormat("globalcache")->format(original, text, sizeof(text));
+    TEST_ASSERT_EQUAL(68, parseTimingCode("globalcache", text).repeatStart);
+    findIRFormat("pronto")->format(original, text, sizeof(text));
+    TEST_ASSERT_EQUAL(68, parseTimingCode("pronto", text).repeatStart);
+    TEST_ASSERT_UINT32_WITHIN(40, original.carrierHz, parseTimingCode("pronto", text).carrierHz);
+}
+
+// Encodes the timings of a pronto code to binary and back
+static uint16_t assertBinaryRoundTrip(const char *pronto, uint8_t *binary, uint16_t maxLength)
+{
+    static uint16_t encoded[MAX_WORDS];
+    static uint16_t decoded[MAX_WORDS];
+    const ir_raw_code_t raw = parseTimingCode("pronto", pronto);
+    ir_timing_layout_t layout, decodedLayout;
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, MAX_WORDS, layout));
+
+    const uint16_t length = encodeBinaryTimings(encoded, layout, binary, maxLength);
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL(parse_ok, decodeBinaryTimings(binary, length, decoded, MAX_WORDS, decodedLayout));
+    TEST_ASSERT_EQUAL(layout.carrierHz, decodedLayout.carrierHz);
+    TEST_ASSERT_EQUAL(layout.length, decodedLayout.length);
+    TEST_ASSERT_EQUAL(layout.loopCount, decodedLayout.loopCount);
+    TEST_ASSERT_EQUAL(layout.repeatLoop, decodedLayout.repeatLoop);
+    TEST_ASSERT_EQUAL_MEMORY(layout.loops, decodedLayout.loops, layout.loopCount * sizeof(ir_timing_loop_t));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(encoded, decoded, layout.length);
+    return length;
+}
+
+void test_binary_codes(void)
+{
+    static char longPronto[4096];
+    static uint8_t binary[1024];
+    buildLongPronto(longPronto, sizeof(longPronto), 200, ' ');
+    const char *codes[] = {NEC_PRONTO, SONY_PRONTO, RC5_PRONTO, RC6_PRONTO, SAMSUNG_PRONTO, longPronto};
+    for (const char *code : codes)
+    {
+        assertBinaryRoundTrip(code, binary, sizeof(binary));
+    }
+
+    // pronto periods and a table of 4 pairs, the 16 bit timings and loops took 158 bytes
+    const uint16_t length = assertBinaryRoundTrip(NEC_PRONTO, binary, sizeof(binary));
+    TEST_ASSERT_TRUE(length < 70);
+    uint16_t timings[128];
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL(parse_length_mismatch, decodeBinaryTimings(binary, length - 1, timings, 128, layout));
+    binary[length] = 0;
+    TEST_ASSERT_EQUAL(parse_length_mismatch, decodeBinaryTimings(binary, length + 1, timings, 128, layout));
+    TEST_ASSERT_EQUAL(parse_too_long, decodeBinaryTimings(binary, length, timings, 20, layout));
+    TEST_ASSERT_EQUAL(0, encodeBinaryTimings(timings, layout, binary, 10));
+    binary[0] = IR_BINARY_VERSION + 1;
+    TEST_ASSERT_EQUAL(parse_invalid_header, decodeBinaryTimings(binary, length, timings, 128, layout));
+
+    // learned codes jitter, they are kept in microseconds without table
+    static uint32_t jittered[100];
+    static char text[1024];
+    for (uint16_t i = 0; i < 100; i++)
+    {
+        jittered[i] = (i % 2 ? 1690 : 560) + (i * 7) % 23;
+    }
+    jittered[99] = 120000;
+    const ir_raw_code_t learned = {38000, jittered, 100, 40, 100};
+    const uint16_t learnedLength = encodeBinaryRaw(learned, binary, sizeof(binary));
+    TEST_ASSERT_TRUE(learnedLength > 0);
+    TEST_ASSERT_TRUE(learnedLength <= 5 + 3 + 100 * 2 + 1);
+    TEST_ASSERT_TRUE(findIRFormat("binary")->format(learned, text, sizeof(text)));
+    const ir_raw_code_t raw = parseTimingCode("binary", text);
+    TEST_ASSERT_EQUAL(38000, raw.carrierHz);
+    TEST_ASSERT_EQUAL(100, raw.count);
+    TEST_ASSERT_EQUAL(40, raw.repeatStart);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(jittered, durations, 100);
+    TEST_ASSERT_EQUAL(parse_invalid_char, parseTimingError("binary", "AaCo*gEK"));
+    TEST_ASSERT_EQUAL(parse_length_mismatch, parseTimingError("binary", "AQ=="));
+
+    // odd codes and zero durations have no binary form
+    const ir_raw_code_t odd = {38000, jittered, 99, 0, 100};
+    TEST_ASSERT_EQUAL(0, encodeBinaryRaw(odd, binary, sizeof(binary)));
+    jittered[10] = 0;
+    TEST_ASSERT_EQUAL(0, encodeBinaryRaw(learned, binary, sizeof(binary)));
+}
+
+void test_jitter_stats(void)
+{
+    // ticks of 0.5us, overruns above 50us
+    IrJitterStats stats(2, 50);
+    ir_jitter_report_t report;
+    stats.report(report);
+    TEST_ASSERT_EQUAL(0, report.frames);
+    TEST_ASSERT_EQUAL(0, report.edgeP99Us);
+
+    // 100 marks and spaces of 500us, one stretched by 80us, the counter wraps
+    uint32_t now = 0xFFFFFF00;
+    stats.startFrame(now);
+    for (uint16_t i = 0; i < 100; i++)
+    {
+        now += 2 * (500 + (i == 50 ? 80 : 0) + (i % 2));
+        stats.edge(now, 500);
+    }
+    stats.endFrame();
+    // edges outside of a frame are ignored
+    stats.edge(now + 1000, 500);
+
+    stats.report(report);
+    TEST_ASSERT_EQUAL(1, report.frames);
+    TEST_ASSERT_EQUAL(100, report.edges);
+    TEST_ASSERT_EQUAL(1, report.overruns);
+    TEST_ASSERT_EQUAL(1, report.overrunFrames);
+    TEST_ASSERT_EQUAL(1, report.windowFrames);
+    TEST_ASSERT_EQUAL(80, report.edgeMaxUs);
+    // every space 1us long
+    TEST_ASSERT_EQUAL(1, report.edgeP99Us);
+    TEST_ASSERT_EQUAL(49, report.edgeHistogram[0]);
+    TEST_ASSERT_EQUAL(50, report.edgeHistogram[1]);
+    TEST_ASSERT_EQUAL(1, report.edgeHistogram[7]);
+    // the frame ended 80 + 50us late
+    TEST_ASSERT_EQUAL(130, report.frameMaxUs);
+    TEST_ASSERT_EQUAL(1, report.frameHistogram[8]);
+
+    // exact frames roll the window over
+    for (uint16_t f = 0; f < 2 * IR_JITTER_WINDOW_FRAMES; f++)
+    {
+        stats.startFrame(now);
+        now += 2 * 560;
+        stats.edge(now, 560);
+        stats.endFrame();
+    }
+    stats.report(report);
+    TEST_ASSERT_EQUAL(1 + 2 * IR_JITTER_WINDOW_FRAMES, report.frames);
+    TEST_ASSERT_EQUAL(IR_JITTER_WINDOW_FRAMES + 1, report.windowFrames);
+    TEST_ASSERT_EQUAL(0, report.edgeMaxUs);
+    TEST_ASSERT_EQUAL(0, report.frameP99Us);
+    TEST_ASSERT_EQUAL(1, report.overruns);
+
+    stats.requestReset();
+    stats.report(report);
+    TEST_ASSERT_EQUAL(1, report.overruns);
+    stats.startFrame(now);
+    stats.report(report);
+    TEST_ASSERT_EQUAL(0, report.frames);
+    TEST_ASSERT_EQUAL(0, report.overruns);
+}
+
+void test_seqlock(void)
+{
+    typedef struct {
+        uint32_t count;
+        uint64_t total;
+    } counters_t;
+    IrSeqlock<counters_t> counters;
+    counters_t copy;
+    counters.read(copy);
+    TEST_ASSERT_EQUAL(0, copy.count);
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        counters_t &update = counters.beginUpdate();
+        update.count++;
+        update.total += 0x100000000ULL;
+        counters.endUpdate();
+    }
+    counters.read(copy);
+    TEST_ASSERT_EQUAL(3, copy.count);
+    TEST_ASSERT_EQUAL_UINT64(0x300000000ULL, copy.total);
+}
+
+void test_jitter_encoded_frames(void)
+{
+    IrJitterStats stats(2, 50);
+    ir_jitter_report_t report;
+
+    // the first frame of a code sets the pace, later ones drift by what they take longer
+    stats.encodedFrame(0xFFFFF000, 0xFFFFF000 + 2 * 67500, 1);
+    stats.encodedFrame(1000, 1000 + 2 * 67520, 1);
+    stats.encodedFrame(1000, 1000 + 2 * 11250, 2);
+    stats.encodedFrame(1000, 1000 + 2 * 67600, 1);
+    stats.report(report);
+    TEST_ASSERT_EQUAL(4, report.frames);
+    TEST_ASSERT_EQUAL(4, report.encodedFrames);
+    TEST_ASSERT_EQUAL(0, report.edges);
+    TEST_ASSERT_EQUAL(1, report.overruns);
+    TEST_ASSERT_EQUAL(1, report.overrunFrames);
+    TEST_ASSERT_EQUAL(100, report.frameMaxUs);
+    TEST_ASSERT_EQUAL(2, report.frameHistogram[0]);
+    TEST_ASSERT_EQUAL(1, report.frameHistogram[5]);
+    TEST_ASSERT_EQUAL(1, report.frameHistogram[7]);
+
+    // a faster frame sets a new pace
+    stats.encodedFrame(0, 2 * 67490, 1);
+    stats.encodedFrame(0, 2 * 67495, 1);
+    stats.report(report);
+    TEST_ASSERT_EQUAL(3, report.frameHistogram[0]);
+    TEST_ASSERT_EQUAL(1, report.frameHistogram[3]);
+
+    stats.requestReset();
+    stats.encodedFrame(0, 2 * 67600, 1);
+    stats.report(report);
+    TEST_ASSERT_EQUAL(1, report.frames);
+    TEST_ASSERT_EQUAL(0, report.overruns);
+}
+
+void test_merge_timelines(void)
+{
+    const uint32_t a[] = {500, 500, 500, 1000};
+    const uint32_t b[] = {250, 500, 1000};
+    const ir_timeline_t lines[] = {{a, 4, 0x01}, {b, 3, 0x06}};
+    ir_segment_t segments[16];
+    uint16_t count = 0;
+
+    TEST_ASSERT_TRUE(mergeTimelines(lines, 2, 100, segments, 16, count));
+    const ir_segment_t expected[] = {{250, 0x07}, {250, 0x01}, {250, 0x00}, {250, 0x06}, {500, 0x07}, {250, 0x06}, {750, 0x00}};
+    TEST_ASSERT_EQUAL(7, count);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(expected[i].durationUs, segments[i].durationUs);
+        TEST_ASSERT_EQUAL_HEX8(expected[i].channels, segments[i].channels);
+    }
+
+    // edges 250us apart cannot be kept apart with a 300us resolution
+    TEST_ASSERT_FALSE(mergeTimelines(lines, 2, 300, segments, 16, count));
+    TEST_ASSERT_FALSE(mergeTimelines(lines, 2, 100, segments, 4, count));
+}
+
+static bool grantRepeats(void *context)
+{
+    uint16_t &repeats = *(uint16_t *)context;
+    if (repeats == 0)
+    {
+        return false;
+    }
+    repeats--;
+    return true;
+}
+
+static bool neverStop()
+{
+    return false;
+}
+
+// The send path played into the capture backend emits the timeline of the code
+void test_transmit_capture(void)
+{
+    static ir_capture_event_t events[256];
+    static uint32_t expected[256];
+    static uint32_t captured[256];
+    IrCaptureTransmitter capture(events, 256);
+
+    const ir_raw_code_t raw = parseTimingCode("pronto", NEC_PRONTO);
+    uint16_t encoded[128];
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, 128, layout));
+    const uint16_t count = expandTimings(encoded, layout, 2, expected, 256);
+
+    uint16_t repeats = 2;
+    const uint32_t gapUs = transmitTimingCode(capture, encoded, layout, grantRepeats, &repeats);
+    TEST_ASSERT_FALSE(capture.overflowed());
+    TEST_ASSERT_EQUAL(3, capture.frames());
+    TEST_ASSERT_EQUAL(raw.carrierHz, capture.at(0).carrierHz);
+    // the trailing gap is left to the caller
+    TEST_ASSERT_EQUAL(count - 1, capture.timeline(captured, 256));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, captured, count - 1);
+    TEST_ASSERT_EQUAL_UINT32(expected[count - 1], gapUs);
+    TEST_ASSERT_EQUAL(0, capture.timeline(captured, 10));
+
+    // merged schedules switch outputs between marks
+    const uint32_t a[] = {500, 500, 500, 1000};
+    const uint32_t b[] = {250, 500, 1000};
+    const ir_timeline_t lines[] = {{a, 4, 0x01}, {b, 3, 0x06}};
+    ir_segment_t segments[16];
+    uint16_t segmentCount = 0;
+    TEST_ASSERT_TRUE(mergeTimelines(lines, 2, 100, segments, 16, segmentCount));
+    capture.clear();
+    capture.enableIROut(38000);
+    TEST_ASSERT_EQUAL_UINT32(750, transmitSegments(capture, segments, segmentCount, neverStop));
+    TEST_ASSERT_EQUAL(6, capture.size());
+    TEST_ASSERT_EQUAL(capture_mark, capture.at(1).kind);
+    TEST_ASSERT_EQUAL_HEX8(0x01, capture.at(1).channels);
+    TEST_ASSERT_EQUAL(capture_space, capture.at(2).kind);
+    TEST_ASSERT_EQUAL_UINT64(1750, capture.durationUs());
+
+    // protocol values are left to the backend
+    capture.clear();
+    TEST_ASSERT_TRUE(capture.sendValue(3, 0x20DF10EF, 32, 2));
+    TEST_ASSERT_EQUAL(capture_value, capture.at(0).kind);
+    TEST_ASSERT_EQUAL_HEX64(0x20DF10EF, capture.at(0).value);
+    TEST_ASSERT_EQUAL(2, capture.at(0).repeats);
+
+    IrCaptureTransmitter tiny(events, 2);
+    transmitTimingCode(tiny, encoded, layout, grantRepeats, &repeats);
+    TEST_ASSERT_TRUE(tiny.overflowed());
+}
+
+void test_protocol_index(void)
+{
+    static const IrProtocolIndex index(PROTOCOL_NAMES);
+    TEST_ASSERT_EQUAL(legacyStrToDecodeType("YORK") + 1, index.size());
+    for (int16_t type = 0; type < index.size(); type++)
+    {
+        TEST_ASSERT_EQUAL(type, index.find(index.name(type)));
+        TEST_ASSERT_EQUAL(legacyStrToDecodeType(index.name(type)), type);
+    }
+    TEST_ASSERT_EQUAL(3, index.find("nec"));
+    TEST_ASSERT_EQUAL_STRING("NEC", index.name(3));
+    TEST_ASSERT_EQUAL(-1, index.find("NEC2"));
+    TEST_ASSERT_EQUAL(-1, index.find(""));
+    TEST_ASSERT_NULL(index.name(-1));
+    TEST_ASSERT_NULL(index.name(index.size()));
+}
+
+// NOR flash: writes only clear bits, erasing sets whole sectors to 0xFF
+static uint32_t logFlash[4 * IR_LOG_SECTOR_SIZE / sizeof(uint32_t)];
+
+static bool logFlashWrite(void *context, uint32_t offset, const void *data, uint32_t length)
+{
+    uint8_t *flash = (uint8_t *)context;
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        flash[offset + i] &= bytes[i];
+    }
+    return true;
+}
+
+static bool logFlashErase(void *context, uint32_t offset, uint32_t length)
+{
+    TEST_ASSERT_EQUAL(0, offset % IR_LOG_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL(0, length % IR_LOG_SECTOR_SIZE);
+    memset((uint8_t *)context + offset, 0xFF, length);
+    return true;
+}
+
+static const ir_flash_ops_t LOG_FLASH_OPS = {logFlash, logFlashWrite, logFlashErase};
+
+static void assertLogCode(const IrCodeLog &log, uint16_t id, const char *name, const uint8_t *payload, uint16_t length)
+{
+    ir_log_entry_t entry;
+    TEST_ASSERT_TRUE(log.find(id, entry));
+    TEST_ASSERT_EQUAL_STRING(name, entry.name);
+    TEST_ASSERT_EQUAL(length, entry.length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, entry.payload, length);
+    if (name[0] != '\0')
+    {
+        TEST_ASSERT_TRUE(log.findName(name, entry));
+        TEST_ASSERT_EQUAL(id, entry.id);
+    }
+}
+
+void test_code_log(void)
+{
+    static uint8_t payload[1500];
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(i * 7);
+    }
+    memset(logFlash, 0, sizeof(logFlash));
+
+    // garbage is formatted, both banks 8 KiB
+    IrCodeLog log((const uint8_t *)logFlash, sizeof(logFlash), LOG_FLASH_OPS);
+    TEST_ASSERT_EQUAL(store_ok, log.begin());
+    TEST_ASSERT_EQUAL(0, log.size());
+    TEST_ASSERT_EQUAL(2 * IR_LOG_SECTOR_SIZE, log.capacity());
+
+    uint16_t id = IR_LOG_NO_ID;
+    TEST_ASSERT_EQUAL(store_ok, log.put(id, "tv_power", payload, 10));
+    TEST_ASSERT_EQUAL(1, id);
+    id = 7;
+    TEST_ASSERT_EQUAL(store_ok, log.put(id, "amp_on", payload + 1, 13));
+    id = IR_LOG_NO_ID;
+    TEST_ASSERT_EQUAL(store_ok, log.put(id, "", payload + 2, 1));
+    TEST_ASSERT_EQUAL(8, id);
+    assertLogCode(log, 1, "tv_power", payload, 10);
+    assertLogCode(log, 7, "amp_on", payload + 1, 13);
+    assertLogCode(log, 8, "", payload + 2, 1);
+
+    // a name keeps its id, and belongs to one code only
+    id = IR_LOG_NO_ID;
+    TEST_ASSERT_EQUAL(store_ok, log.put(id, "amp_on", payload + 3, 20));
+    TEST_ASSERT_EQUAL(7, id);
+    assertLogCode(log, 7, "amp_on", payload + 3, 20);
+    id = 1;
+    TEST_ASSERT_EQUAL(store_name_taken, log.put(id, "amp_on", payload, 4));
+    TEST_ASSERT_EQUAL(store_invalid_name, log.put(id, "a_name_that_is_longer_than_31_ch", payload, 4));
+    TEST_ASSERT_EQUAL(store_too_large, log.put(id, "", payload, 0xFFFF));
+
+    TEST_ASSERT_EQUAL(store_ok, log.remove(8));
+    TEST_ASSERT_EQUAL(store_not_found, log.remove(8));
+    ir_log_entry_t entry;
+    TEST_ASSERT_FALSE(log.find(8, entry));
+    TEST_ASSERT_EQUAL(2, log.size());
+
+    // the codes survive a restart
+    IrCodeLog reopened((const uint8_t *)logFlash, sizeof(logFlash), LOG_FLASH_OPS);
+    TEST_ASSERT_EQUAL(store_ok, reopened.begin());
+    TEST_ASSERT_EQUAL(2, reopened.size());
+    TEST_ASSERT_EQUAL(log.bytesUsed(), reopened.bytesUsed());
+    assertLogCode(reopened, 1, "tv_power", payload, 10);
+    assertLogCode(reopened, 7, "amp_on", payload + 3, 20);
+
+    // replacing a large code over and over compacts the log into the other bank
+    for (uint8_t round = 0; round < 12; round++)
+    {
+        id = 9;
+        TEST_ASSERT_EQUAL(store_ok, reopened.put(id, "big", payload + round, 1400));
+        TEST_ASSERT_TRUE(reopened.bytesUsed() <= reopened.capacity());
+    }
+    assertLogCode(reopened, 1, "tv_power", payload, 10);
+    assertLogCode(reopened, 7, "amp_on", payload + 3, 20);
+    assertLogCode(reopened, 9, "big", payload + 11, 1400);
+    // the bank only holds a few of them
+    for (uint8_t round = 0; round < 5; round++)
+    {
+        id = IR_LOG_NO_ID;
+        const ir_store_error err = reopened.put(id, "", payload, 1400);
+        TEST_ASSERT_TRUE(err == store_ok || err == store_full);
+    }
+    id = IR_LOG_NO_ID;
+    TEST_ASSERT_EQUAL(store_full, reopened.put(id, "", payload, 1400));
+
+    IrCodeLog compacted((const uint8_t *)logFlash, sizeof(logFlash), LOG_FLASH_OPS);
+    TEST_ASSERT_EQUAL(store_ok, compacted.begin());
+    TEST_ASSERT_EQUAL(reopened.size(), compacted.size());
+    assertLogCode(compacted, 9, "big", payload + 11, 1400);
+
+    // a record damaged by a reset while writing falls back to the previous version
+    TEST_ASSERT_EQUAL(store_ok, compacted.remove(10));
+    id = 7;
+    TEST_ASSERT_EQUAL(store_ok, compacted.put(id, "amp_on", payload + 4, 20));
+    compacted.find(7, entry);
+    ((uint8_t *)logFlash)[entry.payload - (const uint8_t *)logFlash + 5] = 0;
+    IrCodeLog torn((const uint8_t *)logFlash, sizeof(logFlash), LOG_FLASH_OPS);
+    TEST_ASSERT_EQUAL(store_ok, torn.begin());
+    assertLogCode(torn, 7, "amp_on", payload + 3, 20);
+    id = IR_LOG_NO_ID;
+    TEST_ASSERT_EQUAL(store_ok, torn.put(id, "vcr", payload, 6));
+    assertLogCode(torn, id, "vcr", payload, 6);
+
+    // without flash area there is no store
+    IrCodeLog none(NULL, 0, LOG_FLASH_OPS);
+    TEST_ASSERT_EQUAL(store_unavailable, none.begin());
+    TEST_ASSERT_EQUAL(store_unavailable, none.put(id, "", payload, 1));
+}
+
+void benchmark_protocol_lookup(void)
+{
+    static const IrProtocolIndex index(PROTOCOL_NAMES);
+    const int iterations = 2000;
+    volatile int32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        for (int16_t type = 0; type < index.size(); type++)
+        {
+            sink += legacyStrToDecodeType(index.name(type));
+        }
+    }
+    auto legacy = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        for (int16_t type = 0; type < index.size(); type++)
+        {
+            sink += index.find(index.name(type));
+        }
+    }
+    auto current = std::chrono::steady_clock::now() - start;
+
+    const double lookups = (double)iterations * index.size();
+    double legacyNs = std::chrono::duration<double, std::nano>(legacy).count() / lookups;
+    double currentNs = std::chrono::duration<double, std::nano>(current).count() / lookups;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "protocol lookup over %u names: linear %.0f ns/op, hash index %.0f ns/op (%.1fx)",
+             (unsigned)index.size(), legacyNs, currentNs, legacyNs / currentNs);
+    TEST_MESSAGE(msg);
+}
+
+void benchmark_pronto_parser(void)
+{
+    static char code[4096];
+    static uint16_t reference[MAX_WORDS];
+    const int iterations = 20000;
+    uint16_t count = 0;
+    volatile uint32_t sink = 0;
+
+    buildLongPronto(code, sizeof(code), 200, ' ');
+
+    legacyBuildPronto(code, reference);
+    parseProntoCode(code, words, MAX_WORDS, count);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(reference, words, count);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        sink += legacyBuildPronto(code, reference);
+    }
+    auto legacy = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        parseProntoCode(code, words, MAX_WORDS, count);
+        sink += count;
+    }
+    auto current = std::chrono::steady_clock::now() - start;
+
+    double legacyNs = std::chrono::duration<double, std::nano>(legacy).count() / iterations;
+    double currentNs = std::chrono::duration<double, std::nano>(current).count() / iterations;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "pronto %u chars: strtok_r %.0f ns/op, single pass %.0f ns/op (%.1fx)",
+             (unsigned)strlen(code), legacyNs, currentNs, legacyNs / currentNs);
+    TEST_MESSAGE(msg);
+}
+
+// Stored size of the timings of pronto codes: text, the 16 bit timings and
+// loops stored before, and the binary form
+typedef struct {
+    uint32_t text;
+    uint32_t timings;
+    uint32_t binary;
+} binary_size_t;
+
+// Reports the size of a code as text, as encoded timings and in binary form,
+// and adds it to `total`.
+static void reportBinarySize(const char *name, const char *format, const char *code, binary_size_t &total)
+{
+    static uint16_t encoded[MAX_WORDS];
+    static uint8_t binary[1024];
+    const ir_raw_code_t raw = parseTimingCode(format, code);
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL(parse_ok, encodeTimings(raw, encoded, MAX_WORDS, layout));
+    const uint32_t text = strlen(code);
+    const uint32_t timings = 6 + layout.loopCount * 6 + layout.length * 2;
+    const uint32_t length = encodeBinaryTimings(encoded, layout, binary, sizeof(binary));
+    TEST_ASSERT_TRUE(length > 0);
+    total.text += text;
+    total.timings += timings;
+    total.binary += length;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%s: %s %u chars, timings %u bytes, binary %u bytes (%.1fx / %.1fx)", name, format,
+             (unsigned)text, (unsigned)timings, (unsigned)length, (double)text / length, (double)timings / length);
+    TEST_MESSAGE(msg);
+}
+
+static void reportBinaryTotal(const char *name, const binary_size_t &total)
+{
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%s: text %u chars, timings %u bytes, binary %u bytes (%.1fx / %.1fx)", name,
+             (unsigned)total.text, (unsigned)total.timings, (unsigned)total.binary,
+             (double)total.text / total.binary, (double)total.timings / total.binary);
+    TEST_MESSAGE(msg);
+}
+
+void benchmark_binary_size(void)
+{
+    static char longPronto[4096];
+    buildLongPronto(longPronto, sizeof(longPronto), 200, ' ');
+    const char *names[] = {"NEC", "SONY", "RC5", "RC6", "SAMSUNG", "long"};
+    const char *codes[] = {NEC_PRONTO, SONY_PRONTO, RC5_PRONTO, RC6_PRONTO, SAMSUNG_PRONTO, longPronto};
+    binary_size_t generated = {0, 0, 0};
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        reportBinarySize(names[i], "pronto", codes[i], generated);
+    }
+    reportBinaryTotal("total generated", generated);
+
+    // durations of learned codes vary, so fewer of them share a table entry
+    binary_size_t learned = {0, 0, 0};
+    for (const learned_code_t &code : LEARNED_CODES)
+    {
+        reportBinarySize(code.name, code.format, code.code, learned);
+    }
+    reportBinaryTotal("total learned", learned);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pronto_nec);
+    RUN_TEST(test_pronto_mixed_delimiters);
+    RUN_TEST(test_pronto_errors);
+    RUN_TEST(test_pronto_long_code);
+    RUN_TEST(test_uccode_fields);
+    RUN_TEST(test_hex_value);
+    RUN_TEST(test_hex_state);
+    RUN_TEST(test_fingerprint_normalization);
+    RUN_TEST(test_slot_allocator);
+    RUN_TEST(test_repeat_budget);
+    RUN_TEST(test_repeat_budget_late_add);
+    RUN_TEST(test_pronto_timings);
+    RUN_TEST(test_timing_loops);
+    RUN_TEST(test_recognize_codes);
+    RUN_TEST(test_timing_formats);
+    RUN_TEST(test_format_round_trip);
+    RUN_TEST(test_merge_timelines);
+    RUN_TEST(test_transmit_capture);
+    RUN_TEST(test_protocol_index);
+    RUN_TEST(test_code_log);
+    RUN_TEST(test_binary_codes);
+    RUN_TEST(test_jitter_stats);
+    RUN_TEST(test_jitter_encoded_frames);
+    RUN_TEST(test_seqlock);
+    RUN_TEST(benchmark_pronto_parser);
+    RUN_TEST(benchmark_protocol_lookup);
+    RUN_TEST(benchmark_binary_size);
+
+    return UNITY_END();
+}
@@ -0,0 +1,235 @@
+// Copyright 2024 Craig Petchell
+
+// Golden waveforms of the native tests: a corpus of codes and the timeline
+// the transmit encoder sends for each, the code with one repeat followed by
+// its trailing gap, in microseconds. Marks and spaces alternate, starting
+// with a mark.
+//
+// After a deliberate change of the encoder, build the tests with
+// -D GOLDEN_UPDATE, paste the printed waveforms here and review the diff.
+
+#ifndef GOLDEN_WAVEFORMS_H_
+#define GOLDEN_WAVEFORMS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    const char *name;
+    const char *format;
+    const char *code;
+    const char *ucCode; // UC code the code is learned as, NULL if no protocol matches
+    uint32_t carrierHz;
+    const uint32_t *waveform;
+    uint16_t waveformLength;
+} golden_code_t;
+
+static const uint32_t NEC_WAVEFORM[] = {
+    8993, 4496, 552, 552, 552, 552, 552, 1683, 552, 552, 552, 552,
+    552, 552, 552, 552, 552, 552, 552, 1683, 552, 1683, 552, 552,
+    552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 552,
+    552, 552, 552, 552, 552, 1683, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 40495, 8993, 2261, 552, 96004,
+};
+
+static const uint32_t SAMSUNG_WAVEFORM[] = {
+    4470, 4470, 552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 552,
+    552, 552, 552, 552, 552, 552, 552, 1683, 552, 1683, 552, 1683,
+    552, 552, 552, 552, 552, 552, 552, 552, 552, 552, 552, 552,
+    552, 1683, 552, 552, 552, 552, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 552, 552, 1683, 552, 1683, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 47121,
+};
+
+static const uint32_t SONY_WAVEFORM[] = {
+    2385, 596, 1193, 596, 596, 596, 1193, 596, 596, 596, 1193, 596,
+    596, 596, 596, 596, 1193, 596, 596, 596, 596, 596, 596, 596,
+    596, 25196, 2385, 596, 1193, 596, 596, 596, 1193, 596, 596, 596,
+    1193, 596, 596, 596, 596, 596, 1193, 596, 596, 596, 596, 596,
+    596, 596, 596, 25196,
+};
+
+static const uint32_t SONY15_WAVEFORM[] = {
+    2409, 602, 1204, 602, 602, 602, 1204, 602, 1204, 602, 602, 602,
+    1204, 602, 602, 602, 602, 602, 602, 602, 602, 602, 1204, 602,
+    602, 602, 602, 602, 602, 602, 602, 21602, 2409, 602, 1204, 602,
+    602, 602, 1204, 602, 1204, 602, 602, 602, 1204, 602, 602, 602,
+    602, 602, 602, 602, 602, 602, 1204, 602, 602, 602, 602, 602,
+    602, 602, 602, 21602,
+};
+
+static const uint32_t SONY20_WAVEFORM[] = {
+    2409, 602, 1204, 602, 602, 602, 1204, 602, 602, 602, 1204, 602,
+    602, 602, 602, 602, 602, 602, 1204, 602, 602, 602, 1204, 602,
+    1204, 602, 602, 602, 1204, 602, 602, 602, 602, 602, 602, 602,
+    1204, 602, 1204, 602, 1204, 12595, 2409, 602, 1204, 602, 602, 602,
+    1204, 602, 602, 602, 1204, 602, 602, 602, 602, 602, 602, 602,
+    1204, 602, 602, 602, 1204, 602, 1204, 602, 602, 602, 1204, 602,
+    602, 602, 602, 602, 602, 602, 1204, 602, 1204, 602, 1204, 12595,
+};
+
+static const uint32_t RC5_WAVEFORM[] = {
+    888, 888, 1776, 888, 888, 888, 888, 888, 888, 888, 888, 888,
+    888, 888, 888, 888, 888, 1776, 888, 888, 1776, 888, 888, 71909,
+    888, 888, 1776, 888, 888, 888, 888, 888, 888, 888, 888, 888,
+    888, 888, 888, 888, 888, 1776, 888, 888, 1776, 888, 888, 71909,
+};
+
+static const uint32_t RC5X_WAVEFORM[] = {
+    1776, 888, 888, 888, 888, 888, 888, 1776, 1776, 1776, 1776, 888,
+    888, 888, 888, 1776, 888, 888, 1776, 88888, 1776, 888, 888, 888,
+    888, 888, 888, 1776, 1776, 1776, 1776, 888, 888, 888, 888, 1776,
+    888, 888, 1776, 88888,
+};
+
+static const uint32_t RC6_WAVEFORM[] = {
+    2663, 888, 444, 888, 444, 444, 444, 444, 444, 888, 888, 444,
+    444, 444, 444, 444, 444, 444, 444, 444, 444, 444, 444, 444,
+    444, 444, 444, 444, 444, 444, 444, 444, 444, 444, 888, 444,
+    444, 888, 444, 444, 444, 71021, 2663, 888, 444, 888, 444, 444,
+    444, 444, 444, 888, 888, 444, 444, 444, 444, 444, 444, 444,
+    444, 444, 444, 444, 444, 444, 444, 444, 444, 444, 444, 444,
+    444, 444, 444, 444, 888, 444, 444, 888, 444, 444, 444, 71021,
+};
+
+static const uint32_t LEARNED_WAVEFORM[] = {
+    3458, 1729, 432, 1297, 432, 432, 432, 1297, 432, 432, 432, 432,
+    432, 1297, 432, 432, 432, 1297, 432, 34584, 3458, 1729, 432, 1297,
+    432, 432, 432, 1297, 432, 432, 432, 432, 432, 1297, 432, 432,
+    432, 1297, 432, 34584,
+};
+
+static const uint32_t NEC_RAW_WAVEFORM[] = {
+    8993, 4496, 552, 552, 552, 552, 552, 1683, 552, 552, 552, 552,
+    552, 552, 552, 552, 552, 552, 552, 1683, 552, 1683, 552, 552,
+    552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 552,
+    552, 552, 552, 552, 552, 1683, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 40495, 8993, 4496, 552, 552,
+    552, 552, 552, 1683, 552, 552, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 1683, 552, 552, 552, 1683, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 552, 552, 552,
+    552, 1683, 552, 552, 552, 552, 552, 552, 552, 552, 552, 1683,
+    552, 1683, 552, 1683, 552, 552, 552, 1683, 552, 1683, 552, 1683,
+    552, 1683, 552, 40495,
+};
+
+static const uint32_t NEC_GLOBALCACHE_WAVEFORM[] = {
+    8993, 4497, 552, 552, 552, 552, 552, 1683, 552, 552, 552, 552,
+    552, 552, 552, 552, 552, 552, 552, 1683, 552, 1683, 552, 552,
+    552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 552,
+    552, 552, 552, 552, 552, 1683, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 40495, 8993, 2261, 552, 96006,
+};
+
+static const uint32_t NEC_BROADLINK_WAVEFORM[] = {
+    8997, 4499, 558, 558, 558, 558, 558, 1675, 558, 558, 558, 558,
+    558, 558, 558, 558, 558, 558, 558, 1675, 558, 1675, 558, 558,
+    558, 1675, 558, 1675, 558, 1675, 558, 1675, 558, 1675, 558, 558,
+    558, 558, 558, 558, 558, 1675, 558, 558, 558, 558, 558, 558,
+    558, 558, 558, 1675, 558, 1675, 558, 1675, 558, 558, 558, 1675,
+    558, 1675, 558, 1675, 558, 1675, 558, 40488, 8997, 4499, 558, 558,
+    558, 558, 558, 1675, 558, 558, 558, 558, 558, 558, 558, 558,
+    558, 558, 558, 1675, 558, 1675, 558, 558, 558, 1675, 558, 1675,
+    558, 1675, 558, 1675, 558, 1675, 558, 558, 558, 558, 558, 558,
+    558, 1675, 558, 558, 558, 558, 558, 558, 558, 558, 558, 1675,
+    558, 1675, 558, 1675, 558, 558, 558, 1675, 558, 1675, 558, 1675,
+    558, 1675, 558, 40488,
+};
+
+static const uint32_t NEC_BINARY_WAVEFORM[] = {
+    8993, 4496, 552, 552, 552, 552, 552, 1683, 552, 552, 552, 552,
+    552, 552, 552, 552, 552, 552, 552, 1683, 552, 1683, 552, 552,
+    552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 1683, 552, 552,
+    552, 552, 552, 552, 552, 1683, 552, 552, 552, 552, 552, 552,
+    552, 552, 552, 1683, 552, 1683, 552, 1683, 552, 552, 552, 1683,
+    552, 1683, 552, 1683, 552, 1683, 552, 40495, 8993, 2261, 552, 96004,
+};
+
+#define GOLDEN_CODE(name, format, code, ucCode, carrierHz)                                                  \
+    {                                                                                                      \
+        #name, format, code, ucCode, carrierHz, name##_WAVEFORM,                                           \
+            sizeof(name##_WAVEFORM) / sizeof(name##_WAVEFORM[0])                                           \
+    }
+
+static const golden_code_t GOLDEN_CODES[] = {
+    // NEC, frame and repeat frame
+    GOLDEN_CODE(NEC, "pronto",
+                "0000 006D 0022 0002 0156 00AB 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 "
+                "0015 0015 0015 0015 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 "
+                "0015 0040 0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 0015 0015 "
+                "0015 0040 0015 0040 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 0015 0040 0015 0604 "
+                "0156 0056 0015 0E43",
+                "NEC;0x20DF10EF;32;0", 38029),
+    // Samsung TV power
+    GOLDEN_CODE(SAMSUNG, "pronto",
+                "0000 006D 0022 0000 00AA 00AA 0015 0040 0015 0040 0015 0040 0015 0015 0015 0015 "
+                "0015 0015 0015 0015 0015 0015 0015 0040 0015 0040 0015 0040 0015 0015 0015 0015 "
+                "0015 0015 0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0015 0015 0015 "
+                "0015 0015 0015 0015 0015 0015 0015 0040 0015 0015 0015 0040 0015 0040 0015 0040 "
+                "0015 0040 0015 0040 0015 0040 0015 0700",
+                "SAMSUNG;0xE0E040BF;32;0", 38029),
+    // Sony power, 12 bits
+    GOLDEN_CODE(SONY, "pronto",
+                "0000 0067 0000 000D 0060 0018 0030 0018 0018 0018 0030 0018 0018 0018 0030 0018 "
+                "0018 0018 0018 0018 0030 0018 0018 0018 0018 0018 0018 0018 0018 03F6",
+                "SONY;0xA90;12;0", 40244),
+    // Sony, 15 bits
+    GOLDEN_CODE(SONY15, "pronto",
+                "0000 0068 0000 0010 0060 0018 0030 0018 0018 0018 0030 0018 0030 0018 0018 0018 "
+                "0030 0018 0018 0018 0018 0018 0018 0018 0018 0018 0030 0018 0018 0018 0018 0018 "
+                "0018 0018 0018 035D",
+                "SONY;0x5A10;15;0", 39857),
+    // Sony, 20 bits
+    GOLDEN_CODE(SONY20, "pronto",
+                "0000 0068 0000 0015 0060 0018 0030 0018 0018 0018 0030 0018 0018 0018 0030 0018 "
+                "0018 0018 0018 0018 0018 0018 0030 0018 0018 0018 0030 0018 0030 0018 0018 0018 "
+                "0030 0018 0018 0018 0018 0018 0018 0018 0030 0018 0030 0018 0030 01F6",
+                "SONY;0xA8B47;20;0", 39857),
+    // RC5 address 0, command 12
+    GOLDEN_CODE(RC5, "pronto",
+                "0000 0073 0000 000C 0020 0020 0040 0020 0020 0020 0020 0020 0020 0020 0020 0020 "
+                "0020 0020 0020 0020 0020 0040 0020 0020 0040 0020 0020 0A20",
+                "RC5;0xC;12;0", 36045),
+    // RC5X address 5, command 70
+    GOLDEN_CODE(RC5X, "pronto",
+                "0000 0073 0000 000A 0040 0020 0020 0020 0020 0020 0020 0040 0040 0040 0040 0020 "
+                "0020 0020 0020 0040 0020 0020 0040 0C84",
+                "RC5X;0x1146;13;0", 36045),
+    // RC6 mode 0, address 0, command 12, frame in both sections
+    GOLDEN_CODE(RC6, "pronto",
+                "0000 0073 0015 0015 0060 0020 0010 0020 0010 0010 0010 0010 0010 0020 0020 0010 "
+                "0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 "
+                "0010 0010 0010 0010 0010 0010 0020 0010 0010 0020 0010 0010 0010 0A00 "
+                "0060 0020 0010 0020 0010 0010 0010 0010 0010 0020 0020 0010 0010 0010 0010 0010 "
+                "0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 0010 "
+                "0010 0010 0020 0010 0010 0020 0010 0010 0010 0A00",
+                "RC6;0xC;20;0", 36045),
+    // learned code of no supported protocol
+    GOLDEN_CODE(LEARNED, "pronto",
+                "0000 0070 0000 000A 0080 0040 0010 0030 0010 0010 0010 0030 0010 0010 0010 0010 "
+                "0010 0030 0010 0010 0010 0030 0010 0500",
+                NULL, 37010),
+    // the NEC frame in the other timing formats
+    GOLDEN_CODE(NEC_RAW, "raw",
+                "38029;8993,4496,552,552,552,552,552,1683,552,552,552,552,552,552,552,552,552,552,552,1683,552,"
+                "1683,552,552,552,1683,552,1683,552,1683,552,1683,552,1683,552,552,552,552,552,552,552,1683,552,"
+                "552,552,552,552,552,552,552,552,1683,552,1683,552,1683,552,552,552,1683,552,1683,552,1683,552,"
+                "1683,552,40495",
+                "NEC;0x20DF10EF;32;0", 38029),
+    GOLDEN_CODE(NEC_GLOBALCACHE, "globalcache",
+                "sendir,1:1,1,38029,1,69,342,171,21,21,21,21,21,64,21,21,21,21,21,21,21,21,21,21,21,64,21,64,21,"
+                "21,21,64,21,64,21,64,21,64,21,64,21,21,21,21,21,21,21,64,21,21,21,21,21,21,21,21,21,64,21,64,21,"
+                "64,21,21,21,64,21,64,21,64,21,64,21,1540,342,86,21,3651",
+                "NEC;0x20DF10EF;32;0", 38029),
+    GOLDEN_CODE(NEC_BROADLINK, "broadlink",
+                "JgBIAAABEokRERERETMRERERERERERERETMRMxERETMRMxEzETMRMxEREREREREzERERERERERERMxEzETMREREzETMRMxEz"
+                "EQAE0Q==",
+                "NEC;0x20DF10EF;32;0", 38000),
+    GOLDEN_CODE(NEC_BINARY, "binary", "AY2pAgEiJAbWAqsBFRUVQBWEDNYCVhXDHEiUJJEiSUqiJJEUSRoL", "NEC;0x20DF10EF;32;0",
+                38029),
+};
+
+#endif
@@ -1,41 +1,223 @@
+// Copyright 2024 Craig Petchell
+
+// Native tests of the way of a code from the request to the pins and back.
+// The codes of the corpus are encoded as queueIR does, sent by the transmit
+// encoder into a capture backend and compared with the golden waveforms in
+// golden_waveforms.h. The waveforms are then learned again as the receiver
+// sees them, down to the UC code receiveIR reports.
+//
+// Build with -D GOLDEN_UPDATE to print the waveforms of the current encoder
+// instead of comparing them.
 
-#include <ArduinoFake.h>
 #include <unity.h>
 #include <stdio.h>
-
-
-using namespace fakeit;
-
-#include <ArduinoJson.h>
+#include <string.h>
+#include <chrono>
+
+#include <ir_formats.h>
+#include <ir_timing.h>
+#include <ir_transmitter.h>
+#include <ir_capture.h>
+#include <ir_recognizer.h>
+#include <ir_uccode.h>
+#include <ir_hex.h>
+
+#include "golden_waveforms.h"
+
+#define MAX_DURATIONS 512
+// IRrecv ends a capture at the first space of its timeout, see ir_task.cpp
+#define RECEIVE_TIMEOUT_US 15000
+// Shortest space between two frames
+#define FRAME_GAP_US 5000
+// Deviation of a learned code sent again, within the resolution of pronto
+#define RESEND_TOLERANCE_US 40
+
+static uint32_t durations[MAX_DURATIONS];
+static uint16_t timings[MAX_DURATIONS];
+static ir_capture_event_t events[MAX_DURATIONS];
+static uint32_t waveform[MAX_DURATIONS];
+static uint32_t received[MAX_DURATIONS];
 
 void setUp(void)
 {
-
-    //ArduinoFakeReset();
-    JsonDocument blub, blab;
 }
 
 void tearDown(void) {
     // clean stuff up here
 }
 
-void blub_test(void){
+static bool grantRepeats(void *context)
+{
+    uint16_t *repeats = (uint16_t *)context;
+    if (*repeats == 0)
+    {
+        return false;
+    }
+    (*repeats)--;
+    return true;
+}
 
+// Encodes a code as buildTimingMessage does and sends it with one repeat as
+// the IR task does. Returns the length of the waveform, which ends with the
+// trailing gap.
+static uint16_t emitWaveform(const char *name, const char *format, const char *code,
+                             IrCaptureTransmitter &capture)
+{
+    const ir_format_handler_t *handler = findIRFormat(format);
+    TEST_ASSERT_NOT_NULL_MESSAGE(handler, name);
+    ir_raw_code_t raw = {0, durations, 0, 0, MAX_DURATIONS};
+    TEST_ASSERT_EQUAL_MESSAGE(parse_ok, handler->parse(code, raw), name);
+    ir_timing_layout_t layout;
+    TEST_ASSERT_EQUAL_MESSAGE(parse_ok, encodeTimings(raw, timings, MAX_DURATIONS, layout), name);
+
+    capture.clear();
+    uint16_t repeats = 1;
+    const uint32_t gapUs = transmitTimingCode(capture, timings, layout, grantRepeats, &repeats);
+    TEST_ASSERT_FALSE_MESSAGE(capture.overflowed(), name);
+    const uint16_t length = capture.timeline(waveform, MAX_DURATIONS - 1);
+    TEST_ASSERT_TRUE_MESSAGE(length > 0, name);
+    waveform[length] = gapUs;
+    return length + 1;
+}
 
-            
+// The first frame of a waveform as the decoders of IRrecv see it. A gap
+// longer than the receive timeout is not measured. IRrecv does not measure
+// the carrier either, the receiver module is tuned to the one of the protocol.
+static ir_raw_code_t receiveFrame(const uint32_t *wave, uint16_t length, uint32_t carrierHz)
+{
+    uint16_t count = 0;
+    while (count < length)
+    {
+        const uint32_t us = wave[count];
+        received[count++] = us;
+        if ((count & 1) == 0 && us >= FRAME_GAP_US)
+        {
+            received[count - 1] = us < RECEIVE_TIMEOUT_US ? us : RECEIVE_TIMEOUT_US;
+            break;
+        }
+    }
+    const ir_raw_code_t raw = {carrierHz, received, count, count, MAX_DURATIONS};
+    return raw;
 }
 
+// UC code of a recognized code, as receiveIR and irNativeCode write it
+static void buildUCCode(const ir_native_code_t &native, char *text, size_t size)
+{
+    snprintf(text, size, "%s;0x%llX;%u;0", native.protocol, (unsigned long long)native.value,
+             (unsigned)native.bits);
+}
 
-int main()
+void test_golden_waveforms(void)
 {
+    IrCaptureTransmitter capture(events, MAX_DURATIONS);
+    for (const golden_code_t &golden : GOLDEN_CODES)
+    {
+        const uint16_t length = emitWaveform(golden.name, golden.format, golden.code, capture);
+#ifdef GOLDEN_UPDATE
+        printf("static const uint32_t %s_WAVEFORM[] = {", golden.name);
+        for (uint16_t i = 0; i < length; i++)
+        {
+            printf(i % 12 ? " %u," : "\n    %u,", (unsigned)waveform[i]);
+        }
+        printf("\n};\n\n");
+#else
+        TEST_ASSERT_EQUAL_MESSAGE(golden.carrierHz, capture.at(0).carrierHz, golden.name);
+        TEST_ASSERT_EQUAL_MESSAGE(golden.waveformLength, length, golden.name);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY_MESSAGE(golden.waveform, waveform, length, golden.name);
+#endif
+    }
+}
 
+// Every waveform is learned as the code it was sent from, and the learned UC
+// code parses back into the same protocol value. Codes of no protocol are
+// kept as timings; sent again, they give the frame that was learned.
+void test_learn_round_trip(void)
+{
+    static char text[4096];
+    IrCaptureTransmitter capture(events, MAX_DURATIONS);
+    for (const golden_code_t &golden : GOLDEN_CODES)
+    {
+        const uint16_t length = emitWaveform(golden.name, golden.format, golden.code, capture);
+        const ir_raw_code_t frame = receiveFrame(waveform, length, capture.at(0).carrierHz);
+
+        ir_native_code_t native;
+        const bool recognized = recognizeIRCode(frame, native);
+        if (golden.ucCode == NULL)
+        {
+            TEST_ASSERT_FALSE_MESSAGE(recognized, golden.name);
+        }
+        else
+        {
+            TEST_ASSERT_TRUE_MESSAGE(recognized, golden.name);
+            buildUCCode(native, text, sizeof(text));
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(golden.ucCode, text, golden.name);
+
+            uc_code_t uc;
+            TEST_ASSERT_EQUAL_MESSAGE(parse_ok, parseUCCode(text, 64, uc), golden.name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(native.protocol, uc.protocol, golden.name);
+            uint64_t value = 0;
+            TEST_ASSERT_EQUAL_MESSAGE(parse_ok, decodeHexValue(uc.code, uc.codeLen, value), golden.name);
+            TEST_ASSERT_EQUAL_UINT64(native.value, value);
+            TEST_ASSERT_EQUAL_MESSAGE(native.bits, uc.bits, golden.name);
+            TEST_ASSERT_EQUAL_MESSAGE(0, uc.repeats, golden.name);
+        }
+
+        // the learned frame has no repeat section, so it is sent once
+        TEST_ASSERT_TRUE_MESSAGE(findIRFormat("pronto")->format(frame, text, sizeof(text)), golden.name);
+        TEST_ASSERT_EQUAL_MESSAGE(frame.count, emitWaveform(golden.name, "pronto", text, capture), golden.name);
+        for (uint16_t i = 0; i < frame.count; i++)
+        {
+            TEST_ASSERT_UINT32_WITHIN_MESSAGE(RESEND_TOLERANCE_US, received[i], waveform[i], golden.name);
+        }
+    }
+}
 
+void benchmark_protocol_codecs(void)
+{
+    const int iterations = 2000;
+    char text[64];
+    volatile uint32_t sink = 0;
+    IrCaptureTransmitter capture(events, MAX_DURATIONS);
+    for (const golden_code_t &golden : GOLDEN_CODES)
+    {
+        uint16_t length = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            length = emitWaveform(golden.name, golden.format, golden.code, capture);
+            sink += length;
+        }
+        auto encode = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            ir_native_code_t native;
+            if (recognizeIRCode(receiveFrame(waveform, length, golden.carrierHz), native))
+            {
+                buildUCCode(native, text, sizeof(text));
+                sink += text[0];
+            }
+        }
+        auto decode = std::chrono::steady_clock::now() - start;
+
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%s: encode %.0f ns/op, decode %.0f ns/op", golden.name,
+                 std::chrono::duration<double, std::nano>(encode).count() / iterations,
+                 std::chrono::duration<double, std::nano>(decode).count() / iterations);
+        TEST_MESSAGE(msg);
+    }
+}
 
+int main()
+{
     UNITY_BEGIN();
 
-RUN_TEST(blub_test);
+    RUN_TEST(test_golden_waveforms);
+#ifndef GOLDEN_UPDATE
+    RUN_TEST(test_learn_round_trip);
+    RUN_TEST(benchmark_protocol_codecs);
+#endif
 
     return UNITY_END();
 }
-
-
@@ -0,0 +1,77 @@
+"""Flash and static RAM saved by the IR protocol profiles of platformio.ini.
+
+Builds every given env once per profile of the [ir_protocols] section and
+prints the sizes PlatformIO reports, compared to the profile "all".
+
+    python tools/ir_protocol_size_report.py [env ...]
+
+The profile is passed through PLATFORMIO_BUILD_FLAGS, so the envs have to
+select ${ir_protocols.all} in their build_flags (as they do by default).
+"""
+
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+PROJECTFILE = "platformio.ini"
+DEFAULT_ENVS = ["koeblaster", "esp32wroom", "olimex_poe_iso"]
+BASELINE = "all"
+
+# e.g. "Flash: [=======   ]  70.1% (used 918761 bytes from 1310720 bytes)"
+SIZE_PATTERN = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)", re.MULTILINE)
+
+
+def read_project():
+    config = configparser.ConfigParser(interpolation=None)
+    config.read(PROJECTFILE)
+    profiles = dict()
+    for name, flags in config.items("ir_protocols"):
+        profiles[name] = " ".join(flags.split())
+    return config, profiles
+
+
+def build_size(env, flags):
+    environment = dict(os.environ)
+    environment["PLATFORMIO_BUILD_FLAGS"] = flags
+    result = subprocess.run(["pio", "run", "-e", env], env=environment,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        print(result.stdout)
+        sys.exit("Build of %s failed" % env)
+    sizes = dict()
+    for match in SIZE_PATTERN.finditer(result.stdout):
+        sizes[match.group(1)] = int(match.group(2))
+    return sizes
+
+
+def main():
+    envs = sys.argv[1:] or DEFAULT_ENVS
+    config, profiles = read_project()
+    if BASELINE not in profiles:
+        sys.exit("No profile %s in [ir_protocols] of %s" % (BASELINE, PROJECTFILE))
+
+    for env in envs:
+        if "${ir_protocols.%s}" % BASELINE not in config.get("env:" + env, "build_flags", fallback=""):
+            print("Warning: env %s does not select ${ir_protocols.%s}, sizes are not comparable" % (env, BASELINE))
+
+    rows = []
+    for env in envs:
+        baseline = None
+        for name, flags in sorted(profiles.items(), key=lambda item: item[0] != BASELINE):
+            print("Building %s with profile %s" % (env, name), file=sys.stderr)
+            sizes = build_size(env, flags)
+            if baseline is None:
+                baseline = sizes
+            rows.append((env, name, sizes["Flash"], baseline["Flash"] - sizes["Flash"],
+                         sizes["RAM"], baseline["RAM"] - sizes["RAM"]))
+
+    print("| Env | Profile | Flash | Flash saved | Static RAM | Static RAM saved |")
+    print("|:----|:--------|------:|------------:|-----------:|-----------------:|")
+    for row in rows:
+        print("| %s | %s | %d | %d | %d | %d |" % row)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,81 @@
+"""Time, heap allocations and peak stack of the IR request path.
+
+Runs the micro-benchmarks of test/benchmark in the env native_benchmark and
+prints their results. They can be saved and compared with an earlier run,
+e.g. of the commit before a change:
+
+    python tools/ir_service_benchmark.py --save before.json
+    python tools/ir_service_benchmark.py --baseline before.json
+
+Times depend on the host and vary between runs by a few percent, allocations
+and stack do not.
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+ENV = "native_benchmark"
+METRICS = ["ns_per_op", "allocs_per_op", "peak_stack_bytes"]
+
+# e.g. 'test/benchmark/test_ir_service/test_main.cpp:218:benchmark_queue_ir:INFO: {"name":...}'
+RESULT_PATTERN = re.compile(r"(\{\"name\":.*\})\s*$", re.MULTILINE)
+
+
+def run_benchmarks():
+    result = subprocess.run(["pio", "test", "-e", ENV, "-v"],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        print(result.stdout)
+        sys.exit("Benchmarks of %s failed" % ENV)
+    results = dict()
+    for match in RESULT_PATTERN.finditer(result.stdout):
+        case = json.loads(match.group(1))
+        results[case.pop("name")] = case
+    if not results:
+        print(result.stdout)
+        sys.exit("No benchmark results in the output of %s" % ENV)
+    return results
+
+
+def change(value, base):
+    if base == 0:
+        return "" if value == 0 else "new"
+    return "%+.1f%%" % ((value - base) * 100.0 / base)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--save", metavar="FILE", help="write the results as JSON")
+    parser.add_argument("--baseline", metavar="FILE", help="compare with results saved by --save")
+    args = parser.parse_args()
+
+    baseline = dict()
+    if args.baseline:
+        with open(args.baseline) as file:
+            baseline = json.load(file)
+
+    results = run_benchmarks()
+    if args.save:
+        with open(args.save, "w") as file:
+            json.dump(results, file, indent=2, sort_keys=True)
+
+    if baseline:
+        print("| Benchmark | ns/op | change | allocs/op | change | peak stack | change |")
+        print("|:----------|------:|-------:|----------:|-------:|-----------:|-------:|")
+    else:
+        print("| Benchmark | ns/op | allocs/op | peak stack |")
+        print("|:----------|------:|----------:|-----------:|")
+    for name, case in results.items():
+        row = [name]
+        for metric in METRICS:
+            row.append("%g" % case[metric])
+            if baseline:
+                row.append(change(case[metric], baseline[name][metric]) if name in baseline else "new")
+        print("| " + " | ".join(row) + " |")
+
+
+if __name__ == "__main__":
+    main()